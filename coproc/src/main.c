@@ -0,0 +1,144 @@
+/*
+ * Coprocessor image: clock filter and trace draining
+ *
+ * Runs on the RISC-V coprocessor (cpuflpr) next to the application.
+ * It turns the calibration samples posted by the application into a
+ * drift-corrected clock model and prints the function trace ring, so
+ * neither costs application core time.  See src/coproc_shm.h.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "coproc_shm.h"
+#include "grtc.h"
+
+#define POLL_MS 1
+
+/* Samples closer together than this are too noisy for a rate estimate */
+#define DRIFT_MIN_SPAN_US 1000000LL
+
+/* Offset changes beyond 500 ppm of the span are a time step, not drift */
+#define DRIFT_MAX_PPM 500
+
+/* Stamp encoding of src/func_trace.c */
+#define FUNC_TRACE_EXIT BIT(31)
+#define FUNC_TRACE_US   (FUNC_TRACE_EXIT - 1U)
+
+static struct {
+	bool valid;
+	uint64_t grtc;
+	int64_t offset_us;
+} last;
+
+static struct coproc_clock model;
+static uint32_t cal_seen;
+
+static void clock_filter(uint64_t utc_us, uint64_t grtc_us)
+{
+	int64_t offset_us = (int64_t)(utc_us - grtc_us);
+
+	if (last.valid && (int64_t)(grtc_us - last.grtc) >= DRIFT_MIN_SPAN_US) {
+		int64_t span = (int64_t)(grtc_us - last.grtc);
+		int64_t step = offset_us - last.offset_us;
+		int64_t limit = span * DRIFT_MAX_PPM / 1000000;
+
+		if (step > limit || step < -limit) {
+			printk("coproc: time step of %lld us\n", step);
+		} else {
+			int64_t drift = step * (1LL << 32) / span;
+
+			/* Exponential average, weight 1/4 */
+			model.drift_q32 = model.calibrated ?
+				model.drift_q32 + (drift - model.drift_q32) / 4 : drift;
+		}
+	}
+
+	last.valid = true;
+	last.grtc = grtc_us;
+	last.offset_us = offset_us;
+
+	model.offset_us = offset_us;
+	model.ref_grtc = grtc_us;
+	model.calibrated = 1;
+}
+
+static void poll_calibration(struct coproc_shm *shm)
+{
+	uint64_t utc_us, grtc_us;
+	uint32_t seq;
+
+	do {
+		seq = coproc_seq_read_begin(&shm->cal.seq);
+		utc_us = shm->cal.utc_us;
+		grtc_us = shm->cal.grtc_us;
+	} while (coproc_seq_read_retry(&shm->cal.seq, seq));
+
+	if (seq == cal_seen) {
+		return;
+	}
+	cal_seen = seq;
+
+	clock_filter(utc_us, grtc_us);
+
+	coproc_seq_write_begin(&shm->clock.seq);
+	shm->clock.model = model;
+	coproc_seq_write_end(&shm->clock.seq);
+}
+
+static void drain_trace(struct coproc_shm *shm)
+{
+	static bool open;
+	/* Read the flush request first: every event recorded before
+	 * func_trace_dump() is then below head.
+	 */
+	bool flush = shm->trace.flush != 0U;
+	uint32_t tail = shm->trace.tail;
+	uint32_t head;
+
+	barrier_dmem_fence_full();
+	head = shm->trace.head;
+	barrier_dmem_fence_full();
+
+	if (head != tail && !open) {
+		printk("FT BEGIN %u %u\n", head - tail, shm->trace.dropped);
+		open = true;
+	}
+
+	for (; tail != head; tail++) {
+		const struct coproc_trace_event *ev =
+			&shm->trace.events[tail & (COPROC_TRACE_EVENTS - 1U)];
+
+		printk("FT %c %08x %u\n", (ev->stamp & FUNC_TRACE_EXIT) ? 'X' : 'E',
+		       ev->fn, ev->stamp & FUNC_TRACE_US);
+	}
+
+	barrier_dmem_fence_full();
+	shm->trace.tail = tail;
+
+	if (flush) {
+		if (open) {
+			printk("FT END\n");
+			open = false;
+		}
+		shm->trace.flush = 0;
+	}
+}
+
+int main(void)
+{
+	struct coproc_shm *shm = COPROC_SHM;
+
+	while (shm->magic != COPROC_SHM_MAGIC) {
+		k_msleep(POLL_MS);
+	}
+
+	printk("coproc: shared memory at %p\n", shm);
+
+	while (true) {
+		poll_calibration(shm);
+		drain_trace(shm);
+		k_msleep(POLL_MS);
+	}
+
+	return 0;
+}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Turn a CONFIG_APP_FUNC_TRACE console dump into a flame graph.
+
+Reads the "FT ..." lines printed by func_trace_dump() from a console log
+(native_sim stdout or a UART capture), resolves addresses against the
+ELF symbol table and writes folded stacks ("a;b;c <us>") that
+flamegraph.pl, inferno or speedscope can render.  A short boot timing
+summary goes to stderr.
+
+Example:
+    ./build/zephyr/zephyr.exe > boot.log
+    scripts/func_trace_flamegraph.py build/zephyr/zephyr.exe boot.log > boot.folded
+    flamegraph.pl boot.folded > boot.svg
+"""
+
+import argparse
+import bisect
+import collections
+import re
+import subprocess
+import sys
+
+STAMP_MASK = (1 << 31) - 1
+EVENT_RE = re.compile(r"FT ([EX]) ([0-9a-fA-F]+) (\d+)")
+
+
+def load_symbols(elf, nm):
+    """Return (sorted addresses, names) of the function symbols in elf."""
+    out = subprocess.run([nm, "-n", "--defined-only", elf],
+                         check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 3 or parts[1] not in "tTwW":
+            continue
+        # Thumb function symbols and pointers carry bit 0; ignore it
+        addrs.append(int(parts[0], 16) & ~1)
+        names.append(parts[2])
+    return addrs, names
+
+
+def resolve(addrs, names, addr):
+    i = bisect.bisect_right(addrs, addr & ~1) - 1
+    return names[i] if i >= 0 else hex(addr)
+
+
+def read_events(stream):
+    events = []
+    for line in stream:
+        if "FT BEGIN" in line:
+            events = []
+            continue
+        m = EVENT_RE.search(line)
+        if m:
+            events.append((m.group(1) == "X", int(m.group(2), 16), int(m.group(3))))
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="zephyr.elf or zephyr.exe of the traced build")
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="console log (default: stdin)")
+    parser.add_argument("--nm", default="nm",
+                        help="nm binary, e.g. arm-zephyr-eabi-nm for target builds")
+    args = parser.parse_args()
+
+    addrs, names = load_symbols(args.elf, args.nm)
+    events = read_events(args.log)
+    if not events:
+        sys.exit("no FT events found in log")
+
+    folded = collections.Counter()
+    total = collections.Counter()
+    stack = []          # [name, entry us, child us]
+    now = events[0][2]  # unwrapped GRTC microseconds
+    last = events[0][2]
+    first_main = None
+
+    for is_exit, addr, stamp in events:
+        now += (stamp - last) & STAMP_MASK
+        last = stamp
+        name = resolve(addrs, names, addr)
+
+        if not is_exit:
+            if name == "main" and first_main is None:
+                first_main = now
+            stack.append([name, now, 0])
+            continue
+
+        # Exits whose entry fell out of the ring are dropped
+        if not any(frame[0] == name for frame in stack):
+            continue
+        while stack:
+            frame = stack.pop()
+            elapsed = now - frame[1]
+            folded[";".join([f[0] for f in stack] + [frame[0]])] += elapsed - frame[2]
+            total[frame[0]] += elapsed
+            if stack:
+                stack[-1][2] += elapsed
+            if frame[0] == name:
+                break
+
+    for path, us in folded.items():
+        if us > 0:
+            print(f"{path} {us}")
+
+    first = events[0][2]
+    print(f"first traced call at GRTC {first} us "
+          "(reset handler + early init on a cold boot)", file=sys.stderr)
+    if first_main is not None:
+        print(f"first traced call -> main(): {first_main - first} us", file=sys.stderr)
+    print("inclusive time, top 10:", file=sys.stderr)
+    for name, us in total.most_common(10):
+        print(f"  {us:>10} us  {name}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,26 @@
+# SPDX-License-Identifier: Apache-2.0
+#
+# Writes a header defining WARM_CACHE_IMAGE_ID, a 32-bit id of the
+# application image: a hash of the files it is built from and of the
+# Zephyr build version.  Run at build time by CMakeLists.txt.
+#
+#   cmake -DOUTPUT=<header> -DFILES=<file|file|...> -DVERSION=<string> -P image_id.cmake
+
+string(REPLACE "|" ";" files "${FILES}")
+
+set(digest "${VERSION}\n")
+foreach(file ${files})
+  if(EXISTS ${file})
+    file(SHA256 ${file} file_hash)
+    string(APPEND digest "${file_hash}\n")
+  endif()
+endforeach()
+
+string(SHA256 digest "${digest}")
+string(SUBSTRING ${digest} 0 8 id)
+
+file(WRITE ${OUTPUT}.tmp
+  "/* Generated by scripts/image_id.cmake */\n"
+  "#define WARM_CACHE_IMAGE_ID 0x${id}U\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Pull retained sections and trace rings over the SMP retained group.
+
+Talks to the MCUmgr group in src/smp_retained.c (group 64) over an SMP
+serial transport (a UART, or the native_sim PTY) or SMP over UDP, reads
+every section in chunks and reports the retrieval throughput.  Needs
+cbor2, and pyserial for --serial.
+
+Example (native_sim, see README.md):
+    ./build/zephyr/zephyr.exe    # prints "uart_1 connected to pseudotty: /dev/pts/N"
+    scripts/smp_retained.py --serial /dev/pts/N --out dump/
+"""
+
+import argparse
+import base64
+import os
+import socket
+import struct
+import sys
+import time
+
+import cbor2
+
+GROUP = 64
+ID_LIST = 0
+ID_READ = 1
+OP_READ = 0
+
+
+def crc16_xmodem(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class SerialTransport:
+    """SMP console framing: base64 frames of at most 127 bytes."""
+
+    MTU = 127
+
+    def __init__(self, port, baud):
+        import serial
+        self.port = serial.Serial(port, baud, timeout=2)
+
+    def send(self, msg):
+        pkt = struct.pack(">H", len(msg) + 2) + msg + struct.pack(">H", crc16_xmodem(msg))
+        enc = base64.b64encode(pkt)
+        first = True
+        while enc:
+            room = self.MTU - 3
+            room -= room % 4
+            chunk, enc = enc[:room], enc[room:]
+            self.port.write((b"\x06\x09" if first else b"\x04\x14") + chunk + b"\n")
+            first = False
+
+    def recv(self):
+        data = b""
+        need = None
+        while need is None or len(data) < need:
+            line = self.port.readline()
+            if not line:
+                raise TimeoutError("no SMP response")
+            if line[:2] not in (b"\x06\x09", b"\x04\x14"):
+                continue  # console output between frames
+            data += base64.b64decode(line[2:].strip())
+            if need is None and len(data) >= 2:
+                need = struct.unpack(">H", data[:2])[0] + 2
+        body, crc = data[2:need - 2], struct.unpack(">H", data[need - 2:need])[0]
+        if crc16_xmodem(body) != crc:
+            raise IOError("SMP frame CRC mismatch")
+        return body
+
+
+class UdpTransport:
+    def __init__(self, addr):
+        host, _, port = addr.rpartition(":")
+        self.addr = (host, int(port))
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(2)
+
+    def send(self, msg):
+        self.sock.sendto(msg, self.addr)
+
+    def recv(self):
+        return self.sock.recv(65535)
+
+
+class Smp:
+    def __init__(self, transport):
+        self.transport = transport
+        self.seq = 0
+
+    def request(self, cmd, payload):
+        body = cbor2.dumps(payload)
+        self.seq = (self.seq + 1) & 0xFF
+        self.transport.send(struct.pack(">BBHHBB", OP_READ, 0, len(body), GROUP, self.seq, cmd) + body)
+        while True:
+            rsp = self.transport.recv()
+            _, _, length, group, seq, rsp_cmd = struct.unpack(">BBHHBB", rsp[:8])
+            if group == GROUP and seq == self.seq and rsp_cmd == cmd:
+                break
+        reply = cbor2.loads(rsp[8:8 + length])
+        if reply.get("rc", 0) != 0:
+            raise IOError(f"SMP error rc={reply['rc']}")
+        return reply
+
+
+def read_section(smp, name):
+    data = b""
+    total = None
+    while total is None or len(data) < total:
+        reply = smp.request(ID_READ, {"sec": name, "off": len(data)})
+        total = reply["len"]
+        if not reply["data"]:
+            break
+        data += reply["data"]
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    link = parser.add_mutually_exclusive_group(required=True)
+    link.add_argument("--serial", help="serial port or PTY of the SMP UART")
+    link.add_argument("--udp", help="HOST:PORT of SMP over UDP (port 1337 by default on the device)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--section", action="append",
+                        help="section to read (default: all listed by the device)")
+    parser.add_argument("--out", help="directory to write <section>.bin files to")
+    args = parser.parse_args()
+
+    smp = Smp(SerialTransport(args.serial, args.baud) if args.serial else UdpTransport(args.udp))
+    listed = smp.request(ID_LIST, {})["sections"]
+    names = args.section or [s["name"] for s in listed]
+
+    if args.out:
+        os.makedirs(args.out, exist_ok=True)
+
+    total_bytes = 0
+    total_time = 0.0
+    for name in names:
+        start = time.perf_counter()
+        data = read_section(smp, name)
+        elapsed = time.perf_counter() - start
+        total_bytes += len(data)
+        total_time += elapsed
+        print(f"{name:14} {len(data):7} bytes  {elapsed * 1000:8.1f} ms  "
+              f"{len(data) / elapsed / 1024:8.1f} KiB/s")
+        if args.out:
+            with open(os.path.join(args.out, f"{name}.bin"), "wb") as f:
+                f.write(data)
+
+    if total_time > 0:
+        print(f"{'total':14} {total_bytes:7} bytes  {total_time * 1000:8.1f} ms  "
+              f"{total_bytes / total_time / 1024:8.1f} KiB/s", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
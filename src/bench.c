@@ -0,0 +1,396 @@
+/*
+ * Boot-time micro-benchmarks
+ *
+ * Every benchmark first checks the optimized routine against a plain
+ * reference implementation, then times CONFIG_APP_BENCH_ITERATIONS
+ * iterations with the timing API.  Each iteration is recorded in a
+ * latency histogram so the report shows the distribution, not just
+ * the mean.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+#include <string.h>
+#include "bench.h"
+#include "latency_hist.h"
+#include "utc_time.h"
+#include "retained.h"
+#include "boot_flags.h"
+#include "mono_time.h"
+#include "fast_clock.h"
+#include "grtc.h"
+
+LOG_MODULE_REGISTER(bench, LOG_LEVEL_INF);
+
+#define BENCH_BATCH 16
+
+/* Inputs shared by all benchmarks, filled by bench_fill() */
+static uint64_t bench_us[BENCH_BATCH];
+
+/* Keeps results alive so the compiler cannot drop the measured work */
+static volatile uint64_t bench_sink;
+
+static uint32_t xorshift_state = 2463534242U;
+
+static uint32_t bench_rand(void)
+{
+	xorshift_state ^= xorshift_state << 13;
+	xorshift_state ^= xorshift_state >> 17;
+	xorshift_state ^= xorshift_state << 5;
+	return xorshift_state;
+}
+
+static void bench_fill(void)
+{
+	/* Realistic UTC values: 2020 .. 2106 with random sub-seconds */
+	for (size_t i = 0; i < BENCH_BATCH; i++) {
+		uint64_t sec = 1577836800ULL + (bench_rand() % 2700000000U);
+
+		bench_us[i] = sec * 1000000ULL + (bench_rand() % 1000000U);
+	}
+}
+
+static LATENCY_HIST_DEFINE(bench_hist);
+
+static void bench_report(const char *name, uint32_t ops)
+{
+	uint64_t p50 = timing_cycles_to_ns(latency_hist_percentile(&bench_hist, 500));
+	uint64_t p99 = timing_cycles_to_ns(latency_hist_percentile(&bench_hist, 990));
+	uint64_t max = timing_cycles_to_ns(latency_hist_max(&bench_hist));
+
+	LOG_INF("%-24s p50 %6llu  p99 %6llu  max %6llu ns/op",
+		name, p50 / ops, p99 / ops, max / ops);
+}
+
+/* Time the statement block once per iteration; it may use bench_i */
+#define BENCH(name, ops, ...)							\
+	do {									\
+		latency_hist_reset(&bench_hist);				\
+		for (int bench_i = 0; bench_i < CONFIG_APP_BENCH_ITERATIONS;	\
+		     bench_i++) {						\
+			timing_t start_ = timing_counter_get();			\
+			__VA_ARGS__;						\
+			timing_t end_ = timing_counter_get();			\
+			latency_hist_record(&bench_hist,			\
+				(uint32_t)timing_cycles_get(&start_, &end_));	\
+		}								\
+		bench_report(name, ops);					\
+	} while (0)
+
+/* Reference conversions using plain 64-bit division */
+static void ref_us_to_ntp(uint64_t us, utc_ntp_time_t *ntp)
+{
+	uint64_t rem = us % 1000000ULL;
+
+	ntp->seconds = (uint32_t)(us / 1000000ULL + 2208988800ULL);
+	ntp->fraction = (uint32_t)(((rem << 32) + 999999ULL) / 1000000ULL);
+}
+
+static void ref_us_to_ptp(uint64_t us, utc_ptp_time_t *ptp)
+{
+	ptp->seconds = us / 1000000ULL;
+	ptp->nanoseconds = (uint32_t)(us % 1000000ULL) * 1000U;
+}
+
+static bool bench_verify_conversions(void)
+{
+	for (int i = 0; i < CONFIG_APP_BENCH_ITERATIONS; i++) {
+		uint64_t us = ((uint64_t)bench_rand() << 32 | bench_rand()) % 4000000000000000ULL;
+		utc_ntp_time_t ntp, ntp_ref;
+		utc_ptp_time_t ptp, ptp_ref;
+
+		utc_time_us_to_ntp(us, &ntp);
+		ref_us_to_ntp(us, &ntp_ref);
+		utc_time_us_to_ptp(us, &ptp);
+		ref_us_to_ptp(us, &ptp_ref);
+
+		if (ntp.seconds != ntp_ref.seconds || ntp.fraction != ntp_ref.fraction ||
+		    utc_time_ntp_to_us(&ntp) != us ||
+		    ptp.seconds != ptp_ref.seconds || ptp.nanoseconds != ptp_ref.nanoseconds ||
+		    utc_time_ptp_to_us(&ptp) != us) {
+			LOG_ERR("Conversion mismatch for %llu us", us);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void bench_conversions(void)
+{
+	utc_ntp_time_t ntp[BENCH_BATCH];
+	utc_ptp_time_t ptp[BENCH_BATCH];
+	uint64_t out[BENCH_BATCH];
+
+	if (!bench_verify_conversions()) {
+		return;
+	}
+
+	BENCH("us->ntp (division)", BENCH_BATCH, {
+		for (size_t j = 0; j < BENCH_BATCH; j++) {
+			ref_us_to_ntp(bench_us[j], &ntp[j]);
+		}
+		bench_sink += ntp[bench_i % BENCH_BATCH].fraction;
+	});
+
+	BENCH("us->ntp", BENCH_BATCH, {
+		utc_time_us_to_ntp_batch(bench_us, ntp, BENCH_BATCH);
+		bench_sink += ntp[bench_i % BENCH_BATCH].fraction;
+	});
+
+	BENCH("ntp->us", BENCH_BATCH, {
+		utc_time_ntp_to_us_batch(ntp, out, BENCH_BATCH);
+		bench_sink += out[bench_i % BENCH_BATCH];
+	});
+
+	BENCH("us->ptp (division)", BENCH_BATCH, {
+		for (size_t j = 0; j < BENCH_BATCH; j++) {
+			ref_us_to_ptp(bench_us[j], &ptp[j]);
+		}
+		bench_sink += ptp[bench_i % BENCH_BATCH].nanoseconds;
+	});
+
+	BENCH("us->ptp", BENCH_BATCH, {
+		utc_time_us_to_ptp_batch(bench_us, ptp, BENCH_BATCH);
+		bench_sink += ptp[bench_i % BENCH_BATCH].nanoseconds;
+	});
+
+	BENCH("ptp->us", BENCH_BATCH, {
+		utc_time_ptp_to_us_batch(ptp, out, BENCH_BATCH);
+		bench_sink += out[bench_i % BENCH_BATCH];
+	});
+}
+
+static const struct {
+	const char *str;
+	uint64_t us;
+} parse_vectors[] = {
+	{ "1970-01-01T00:00:00Z", 0ULL },
+	{ "2025-12-11T00:00:00Z", 1765411200000000ULL },
+	{ "2024-02-29T12:00:00.5Z", 1709208000500000ULL },
+	{ "2025-12-11T08:30:00.123456789+05:30", 1765422000123456ULL },
+	{ "2016-12-31T23:59:60Z", 1483228800000000ULL },
+};
+
+static const char *const parse_rejects[] = {
+	"1969-12-31T23:59:59Z",
+	"2023-02-29T00:00:00Z",
+	"2025-12-11T08:30:00",
+	"2025-12-11T08:30:00.Z",
+	"2025-12-11T24:00:00Z",
+	"2025-12-11T08:30:00+0530",
+};
+
+static void bench_parse(void)
+{
+	const char *str = parse_vectors[3].str;
+	size_t len = strlen(str);
+	uint64_t us;
+
+	for (size_t i = 0; i < ARRAY_SIZE(parse_vectors); i++) {
+		const char *v = parse_vectors[i].str;
+
+		if (utc_time_parse_rfc3339(v, strlen(v), &us) != 0 ||
+		    us != parse_vectors[i].us) {
+			LOG_ERR("RFC 3339 parse mismatch: %s", v);
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(parse_rejects); i++) {
+		const char *v = parse_rejects[i];
+
+		if (utc_time_parse_rfc3339(v, strlen(v), &us) == 0) {
+			LOG_ERR("RFC 3339 accepted invalid input: %s", v);
+			return;
+		}
+	}
+
+	BENCH("rfc3339 parse", 1, {
+		(void)utc_time_parse_rfc3339(str, len, &us);
+		bench_sink += us;
+	});
+}
+
+/* Reference ISO 8601 rendering: walks years and months */
+static void ref_format_iso(uint64_t us, char *buffer, size_t size)
+{
+	static const uint8_t mdays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	uint64_t sec = us / 1000000ULL;
+	uint32_t days = (uint32_t)(sec / 86400U);
+	uint32_t sod = (uint32_t)(sec % 86400U);
+	int y = 1970;
+	int m = 0;
+
+	for (;;) {
+		bool leap = (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0));
+		uint32_t ydays = leap ? 366U : 365U;
+
+		if (days < ydays) {
+			break;
+		}
+		days -= ydays;
+		y++;
+	}
+
+	bool leap = (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0));
+
+	for (;; m++) {
+		uint32_t n = mdays[m] + ((m == 1 && leap) ? 1U : 0U);
+
+		if (days < n) {
+			break;
+		}
+		days -= n;
+	}
+
+	(void)snprintf(buffer, size, "%04d-%02d-%02uT%02u:%02u:%02u.%06uZ", y, m + 1,
+		       days + 1U, sod / 3600U, (sod / 60U) % 60U, sod % 60U,
+		       (uint32_t)(us % 1000000ULL));
+}
+
+/* Stamping a stream of records: consecutive microseconds mostly share
+ * a second and hit the cached prefix.  utc_time_format_us() is the
+ * existing full snprintf rendering.
+ */
+static void bench_format(void)
+{
+	char out[32];
+	char ref[32];
+	uint64_t base = bench_us[0];
+
+	for (int i = 0; i < CONFIG_APP_BENCH_ITERATIONS; i++) {
+		uint64_t us = (i & 1) ? base + (uint64_t)i * 997U :
+			      ((uint64_t)bench_rand() << 32 | bench_rand()) %
+			      (UTC_TIME_ISO_MAX_SEC * 1000000ULL);
+
+		ref_format_iso(us, ref, sizeof(ref));
+		if (utc_time_format_iso_us(us, out, sizeof(out)) != 27 ||
+		    strcmp(out, ref) != 0) {
+			LOG_ERR("ISO format mismatch for %llu us: %s != %s", us, out, ref);
+			return;
+		}
+	}
+
+	BENCH("format_us (s.ms.us)", 1, {
+		bench_sink += utc_time_format_us(base + bench_i, out, sizeof(out));
+	});
+
+	BENCH("iso cached, same second", 1, {
+		bench_sink += utc_time_format_iso_us(base + bench_i, out, sizeof(out));
+	});
+
+	/* Every call misses: a full render plus the cache update */
+	BENCH("iso, new second", 1, {
+		bench_sink += utc_time_format_iso_us(bench_us[bench_i % BENCH_BATCH] +
+						     (uint64_t)bench_i * 1000000ULL,
+						     out, sizeof(out));
+	});
+}
+
+#ifdef CONFIG_APP_BOOT_FLAGS
+/* One boot flag through GPREGRET versus the CRC'd store of struct
+ * retained_data that retained_update() performs.  Both leave the
+ * stored state as they found it.
+ */
+static void bench_boot_flags(void)
+{
+	struct retained_data copy;
+
+	BENCH("boot flag set+clear", 2, {
+		boot_flags_set(BOOT_FLAG_SKIP_SELF_TEST);
+		boot_flags_clear(BOOT_FLAG_SKIP_SELF_TEST);
+	});
+
+	BENCH("retained store", 1, {
+		(void)retained_blob_write(0, &retained,
+					  offsetof(struct retained_data, crc));
+	});
+
+	BENCH("boot flag get", 1, {
+		bench_sink += boot_flags_get();
+	});
+
+	BENCH("retained load", 1, {
+		bench_sink += retained_blob_read(0, &copy,
+						 offsetof(struct retained_data, crc));
+	});
+}
+#endif
+
+#ifdef CONFIG_APP_MONO_TIME
+static void bench_mono_time(void)
+{
+	BENCH("grtc_read_us", 1, {
+		bench_sink += grtc_read_us();
+	});
+
+	BENCH("mono_time_get_us", 1, {
+		bench_sink += mono_time_get_us();
+	});
+}
+#endif
+
+#ifdef CONFIG_APP_FAST_CLOCK
+static void bench_fast_clock(void)
+{
+	BENCH("fast_clock_get_us", 1, {
+		bench_sink += fast_clock_get_us();
+	});
+
+	BENCH("fast_clock precise", 1, {
+		bench_sink += fast_clock_get_precise_us();
+	});
+
+	/* Extrapolation error against back-to-back GRTC reads, in us;
+	 * the core stays busy between reads, then sleeps between them
+	 * (reads then lag by the sleeps since the last resync).
+	 */
+	for (int idle = 0; idle < 2; idle++) {
+		latency_hist_reset(&bench_hist);
+		for (int i = 0; i < CONFIG_APP_BENCH_ITERATIONS; i++) {
+			uint64_t fast = fast_clock_get_us();
+			uint64_t grtc = grtc_read_us();
+			uint64_t error = (fast > grtc) ? fast - grtc : grtc - fast;
+
+			latency_hist_record(&bench_hist, (uint32_t)MIN(error, UINT32_MAX));
+			if (idle) {
+				k_usleep(bench_rand() % 1000U);
+			} else {
+				k_busy_wait(bench_rand() % 1000U);
+			}
+		}
+		LOG_INF("%-24s p50 %6u  p99 %6u  max %6u us (max at resync %u us)",
+			idle ? "fast_clock error, idle" : "fast_clock error, busy",
+			latency_hist_percentile(&bench_hist, 500),
+			latency_hist_percentile(&bench_hist, 990),
+			latency_hist_max(&bench_hist), fast_clock_max_error_us());
+	}
+}
+#endif
+
+void bench_run(void)
+{
+	timing_init();
+	timing_start();
+
+	LOG_INF("=== Benchmarks (%u MHz timing clock) ===", timing_freq_get_mhz());
+	bench_fill();
+	bench_conversions();
+	bench_parse();
+	bench_format();
+#ifdef CONFIG_APP_BOOT_FLAGS
+	bench_boot_flags();
+#endif
+#ifdef CONFIG_APP_MONO_TIME
+	bench_mono_time();
+#endif
+#ifdef CONFIG_APP_FAST_CLOCK
+	bench_fast_clock();
+#endif
+
+	/* The counter is left running: the profiler and the fast clock
+	 * share it.
+	 */
+}
@@ -0,0 +1,13 @@
+/*
+ * Boot-time micro-benchmarks - Header File
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @brief Run all micro-benchmarks and log the results
+ */
+void bench_run(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,77 @@
+/*
+ * Boot flags in GPREGRET
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include "boot_flags.h"
+
+#if DT_NODE_HAS_STATUS_OKAY(DT_ALIAS(bootflagsdevice))
+/* The register itself rather than the retained_mem driver, whose
+ * mutex would rule out interrupt, fatal error and pre-kernel callers
+ */
+#define BOOT_FLAGS_REG ((volatile uint8_t *)DT_REG_ADDR(DT_ALIAS(bootflagsdevice)))
+#elif defined(CONFIG_ARCH_POSIX)
+/* native_sim: emulate the register like the retained region */
+#define BOOT_FLAGS_EMULATED
+static uint8_t boot_flags_reg;
+#else
+#error "bootflagsdevice alias not defined"
+#endif
+
+/* Serializes the read-modify-write of set/clear/take; plain reads are
+ * single byte accesses and need no lock.
+ */
+static struct k_spinlock boot_flags_lock;
+
+static uint8_t reg_read(void)
+{
+#ifdef BOOT_FLAGS_EMULATED
+	return boot_flags_reg;
+#else
+	return *BOOT_FLAGS_REG;
+#endif
+}
+
+static void reg_write(uint8_t val)
+{
+#ifdef BOOT_FLAGS_EMULATED
+	boot_flags_reg = val;
+#else
+	*BOOT_FLAGS_REG = val;
+#endif
+}
+
+uint8_t boot_flags_get(void)
+{
+	return reg_read();
+}
+
+void boot_flags_set(uint8_t mask)
+{
+	k_spinlock_key_t key = k_spin_lock(&boot_flags_lock);
+
+	reg_write(reg_read() | mask);
+	k_spin_unlock(&boot_flags_lock, key);
+}
+
+void boot_flags_clear(uint8_t mask)
+{
+	k_spinlock_key_t key = k_spin_lock(&boot_flags_lock);
+
+	reg_write(reg_read() & ~mask);
+	k_spin_unlock(&boot_flags_lock, key);
+}
+
+uint8_t boot_flags_take(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&boot_flags_lock);
+	uint8_t val = reg_read();
+
+	if (val != 0U) {
+		reg_write(0);
+	}
+	k_spin_unlock(&boot_flags_lock, key);
+
+	return val;
+}
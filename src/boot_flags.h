@@ -0,0 +1,74 @@
+/*
+ * Boot flags in GPREGRET - Header File
+ *
+ * A few bits of state for the next boot (boot mode, skip-self-test,
+ * reset reason) that do not justify a CRC'd rewrite of struct
+ * retained_data on the reset path.  They live in an nRF general
+ * purpose retention register (nordic,nrf-gpregret), where a one byte
+ * store is atomic and no checksum is needed.  Read-modify-writes are
+ * done on the register under a spinlock, so flags can be set from
+ * interrupts, fatal error handlers and pre-kernel code.  GPREGRET is
+ * cleared by power-on and brown-out resets only.
+ */
+
+#ifndef BOOT_FLAGS_H
+#define BOOT_FLAGS_H
+
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+/* Skip the boot-time self tests on the next boot */
+#define BOOT_FLAG_SKIP_SELF_TEST  BIT(0)
+
+/* The application requested the reset (sys_reboot()); a reset without
+ * this flag was caused by something else, e.g. the watchdog.
+ */
+#define BOOT_FLAG_RESET_REQUESTED BIT(1)
+
+/* Boot mode for the next boot, use FIELD_PREP() / FIELD_GET() */
+#define BOOT_FLAGS_MODE_MASK      GENMASK(3, 2)
+
+/* Application-defined reset reason code, use FIELD_PREP() / FIELD_GET() */
+#define BOOT_FLAGS_REASON_MASK    GENMASK(7, 4)
+
+#ifdef CONFIG_APP_BOOT_FLAGS
+
+/**
+ * @brief Read the boot flags
+ */
+uint8_t boot_flags_get(void);
+
+/**
+ * @brief Set the given flag bits, leaving the others unchanged
+ *
+ * Callable from any context: threads, interrupts, fatal error
+ * handlers and before the kernel starts.
+ */
+void boot_flags_set(uint8_t mask);
+
+/**
+ * @brief Clear the given flag bits, leaving the others unchanged
+ *
+ * Callable from any context: threads, interrupts, fatal error
+ * handlers and before the kernel starts.
+ */
+void boot_flags_clear(uint8_t mask);
+
+/**
+ * @brief Read and clear all boot flags
+ *
+ * Call once at boot so the flags only apply to the boot that follows
+ * the one that set them.
+ */
+uint8_t boot_flags_take(void);
+
+#else
+
+static inline uint8_t boot_flags_get(void) { return 0; }
+static inline void boot_flags_set(uint8_t mask) {}
+static inline void boot_flags_clear(uint8_t mask) {}
+static inline uint8_t boot_flags_take(void) { return 0; }
+
+#endif /* CONFIG_APP_BOOT_FLAGS */
+
+#endif /* BOOT_FLAGS_H */
@@ -0,0 +1,259 @@
+/*
+ * Timer coalescing with slack windows
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include "coalesce.h"
+#include "grtc.h"
+
+LOG_MODULE_REGISTER(coalesce, LOG_LEVEL_INF);
+
+static sys_slist_t tasks = SYS_SLIST_STATIC_INIT(&tasks);
+static struct k_spinlock lock;
+
+/* Window end the wakeup is programmed for, UINT64_MAX if none */
+static uint64_t armed_us = UINT64_MAX;
+
+static uint32_t wakeups;
+static uint32_t task_runs;
+static uint64_t start_us;
+
+static void run_work_handler(struct k_work *work);
+static K_WORK_DEFINE(run_work, run_work_handler);
+
+#ifdef CONFIG_NRF_GRTC_TIMER
+static int32_t chan = -1;
+
+static void compare_handler(int32_t id, uint64_t cc_value, void *user_data)
+{
+	ARG_UNUSED(id);
+	ARG_UNUSED(cc_value);
+	ARG_UNUSED(user_data);
+
+	wakeups++;
+	k_work_submit(&run_work);
+}
+#else
+static void wake_timer_expiry(struct k_timer *timer)
+{
+	ARG_UNUSED(timer);
+
+	wakeups++;
+	k_work_submit(&run_work);
+}
+
+static K_TIMER_DEFINE(wake_timer, wake_timer_expiry, NULL);
+#endif
+
+/* Program the wakeup for the earliest window end.  Caller holds the
+ * lock.
+ */
+static void rearm(void)
+{
+	struct coalesce_task *task;
+	uint64_t target = UINT64_MAX;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&tasks, task, node) {
+		target = MIN(target, task->deadline_us + task->slack_us);
+	}
+
+	if (target == armed_us) {
+		return;
+	}
+	armed_us = target;
+
+#ifdef CONFIG_NRF_GRTC_TIMER
+	if (target == UINT64_MAX) {
+		z_nrf_grtc_timer_abort(chan);
+	} else {
+		/* A window end already passed fires at once */
+		(void)z_nrf_grtc_timer_set(chan, target, compare_handler, NULL);
+	}
+#else
+	/* Relative to the GRTC now: do not assume it equals the uptime */
+	if (target == UINT64_MAX) {
+		k_timer_stop(&wake_timer);
+	} else {
+		uint64_t now = grtc_read_us();
+
+		k_timer_start(&wake_timer, K_USEC((target > now) ? target - now : 0U), K_NO_WAIT);
+	}
+#endif
+}
+
+/* Caller holds the lock */
+static void unlink(struct coalesce_task *task)
+{
+	if (task->pending) {
+		(void)sys_slist_find_and_remove(&tasks, &task->node);
+		task->pending = false;
+	}
+}
+
+void coalesce_schedule(struct coalesce_task *task, uint64_t deadline_us)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (start_us == 0U) {
+		start_us = grtc_read_us();
+	}
+
+	unlink(task);
+	task->deadline_us = deadline_us;
+	sys_slist_append(&tasks, &task->node);
+	task->pending = true;
+	rearm();
+
+	k_spin_unlock(&lock, key);
+}
+
+void coalesce_schedule_in(struct coalesce_task *task, uint32_t delay_us)
+{
+	coalesce_schedule(task, grtc_read_us() + delay_us);
+}
+
+void coalesce_cancel(struct coalesce_task *task)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	unlink(task);
+	rearm();
+	k_spin_unlock(&lock, key);
+}
+
+/* Run every task whose window has opened, one at a time and outside
+ * the lock, then program the next wakeup.
+ */
+static void run_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	for (;;) {
+		k_spinlock_key_t key = k_spin_lock(&lock);
+		uint64_t now = grtc_read_us();
+		struct coalesce_task *task;
+		struct coalesce_task *due = NULL;
+
+		SYS_SLIST_FOR_EACH_CONTAINER(&tasks, task, node) {
+			if (task->deadline_us <= now) {
+				due = task;
+				break;
+			}
+		}
+
+		if (due == NULL) {
+			/* The compare has fired: program it even if the
+			 * earliest window end did not change
+			 */
+			armed_us = UINT64_MAX;
+			rearm();
+			k_spin_unlock(&lock, key);
+			return;
+		}
+
+		uint32_t late = (uint32_t)MIN(now - due->deadline_us, UINT32_MAX);
+
+		due->runs++;
+		due->late_sum_us += late;
+		due->late_max_us = MAX(due->late_max_us, late);
+		if (late > due->slack_us) {
+			due->missed++;
+		}
+		task_runs++;
+
+		unlink(due);
+		if (due->period_us != 0U) {
+			/* Keep the schedule; skip periods missed entirely */
+			uint64_t periods = (now - due->deadline_us) / due->period_us + 1U;
+
+			due->deadline_us += periods * due->period_us;
+			sys_slist_append(&tasks, &due->node);
+			due->pending = true;
+		}
+
+		k_spin_unlock(&lock, key);
+
+		due->fn(due);
+	}
+}
+
+void coalesce_print(void)
+{
+	struct coalesce_task *task;
+	uint64_t elapsed_ms = (grtc_read_us() - start_us) / 1000U;
+	uint32_t w = wakeups;
+	uint32_t runs = task_runs;
+
+	if (elapsed_ms == 0U) {
+		return;
+	}
+
+	LOG_INF("Coalescing: %u wakeups for %u task runs in %llu ms "
+		"(%llu.%02llu wakeups/s, %u%% saved)", w, runs, elapsed_ms,
+		(uint64_t)w * 1000U / elapsed_ms, ((uint64_t)w * 100000U / elapsed_ms) % 100U,
+		(w < runs) ? (uint32_t)(100U - (uint64_t)w * 100U / runs) : 0U);
+
+	/* Reading the list unlocked is fine for a report */
+	SYS_SLIST_FOR_EACH_CONTAINER(&tasks, task, node) {
+		LOG_INF("  %-12s period %6u slack %6u us: %5u runs, late mean %6llu max %6u us, "
+			"missed %u", task->name, task->period_us, task->slack_us, task->runs,
+			task->runs ? task->late_sum_us / task->runs : 0U, task->late_max_us,
+			task->missed);
+	}
+}
+
+#ifdef CONFIG_NRF_GRTC_TIMER
+static int coalesce_init(void)
+{
+	chan = z_nrf_grtc_timer_chan_alloc();
+	if (chan < 0) {
+		LOG_ERR("No GRTC channel for coalescing");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+SYS_INIT(coalesce_init, POST_KERNEL, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
+
+#ifdef CONFIG_APP_COALESCE_DEMO
+
+/* Stand-ins for the application's periodic activities: only the
+ * timing matters here.
+ */
+static void demo_fn(struct coalesce_task *task)
+{
+	ARG_UNUSED(task);
+}
+
+static void report_fn(struct coalesce_task *task)
+{
+	ARG_UNUSED(task);
+	coalesce_print();
+}
+
+static COALESCE_TASK_DEFINE(wdt_feed, demo_fn, 500000U, 100000U);
+static COALESCE_TASK_DEFINE(status, demo_fn, 1000000U, 250000U);
+static COALESCE_TASK_DEFINE(sync_poll, demo_fn, 2000000U, 500000U);
+static COALESCE_TASK_DEFINE(checkpoint, demo_fn, 10000000U, 2000000U);
+#define REPORT_US ((uint32_t)CONFIG_APP_COALESCE_REPORT_S * 1000000U)
+
+static COALESCE_TASK_DEFINE(report, report_fn, REPORT_US, REPORT_US / 6U);
+
+void coalesce_demo_start(void)
+{
+	/* Unrelated phases, as independent timers would have */
+	coalesce_schedule_in(&wdt_feed, 50000U);
+	coalesce_schedule_in(&status, 130000U);
+	coalesce_schedule_in(&sync_poll, 370000U);
+	coalesce_schedule_in(&checkpoint, 910000U);
+	coalesce_schedule_in(&report, REPORT_US);
+
+	LOG_INF("Coalescing demo: 4 tasks (3.6 wakeups/s as separate timers), "
+		"report every %u s", CONFIG_APP_COALESCE_REPORT_S);
+}
+
+#endif /* CONFIG_APP_COALESCE_DEMO */
@@ -0,0 +1,114 @@
+/*
+ * Timer coalescing with slack windows - Header File
+ *
+ * Periodic activities register a task with a deadline and a slack:
+ * the task may run anywhere in [deadline, deadline + slack].  Instead
+ * of one kernel timer per activity, one GRTC compare channel is armed
+ * at the earliest window end among the pending tasks, and every task
+ * whose window has opened by then runs on that wakeup.  Picking the
+ * earliest window end is the greedy that stabs all windows with the
+ * fewest points, so the CPU wakes as rarely as the slacks allow.
+ *
+ * Tasks run one after another from the system work queue.  Periodic
+ * tasks keep their schedule: the next deadline is the previous one
+ * plus the period, independent of how late the run was.
+ *
+ * On targets without the GRTC driver (native_sim) a kernel timer
+ * stands in for the compare channel.
+ */
+
+#ifndef COALESCE_H
+#define COALESCE_H
+
+#include <stdint.h>
+#include <zephyr/sys/slist.h>
+
+struct coalesce_task;
+
+typedef void (*coalesce_fn_t)(struct coalesce_task *task);
+
+struct coalesce_task {
+	const char *name;
+	coalesce_fn_t fn;
+	uint32_t period_us;     /* 0 for a one-shot task */
+	uint32_t slack_us;
+
+	/* Scheduler state */
+	sys_snode_t node;
+	uint64_t deadline_us;   /* GRTC */
+	bool pending;
+
+	/* Statistics, lateness = run start - deadline */
+	uint32_t runs;
+	uint32_t missed;        /* runs later than the slack */
+	uint32_t late_max_us;
+	uint64_t late_sum_us;
+};
+
+#define COALESCE_TASK_INITIALIZER(_name, _fn, _period_us, _slack_us)	\
+	{								\
+		.name = (_name),					\
+		.fn = (_fn),						\
+		.period_us = (_period_us),				\
+		.slack_us = (_slack_us),				\
+	}
+
+/**
+ * @brief Statically define a task
+ *
+ * @param var Variable name
+ * @param fn Called from the system work queue when the task runs
+ * @param period_us Period in microseconds, 0 for one-shot
+ * @param slack_us How late the task may run after its deadline
+ */
+#define COALESCE_TASK_DEFINE(var, fn, period_us, slack_us)		\
+	struct coalesce_task var =					\
+		COALESCE_TASK_INITIALIZER(#var, fn, period_us, slack_us)
+
+#ifdef CONFIG_APP_COALESCE
+
+/**
+ * @brief Schedule a task at an absolute GRTC deadline
+ *
+ * Replaces a pending deadline of the same task.  Any context.
+ *
+ * @param task Task to schedule
+ * @param deadline_us Earliest GRTC time to run at
+ */
+void coalesce_schedule(struct coalesce_task *task, uint64_t deadline_us);
+
+/**
+ * @brief Schedule a task @p delay_us from now
+ *
+ * @param task Task to schedule
+ * @param delay_us Delay of the first deadline in microseconds
+ */
+void coalesce_schedule_in(struct coalesce_task *task, uint32_t delay_us);
+
+/**
+ * @brief Remove a task from the schedule
+ */
+void coalesce_cancel(struct coalesce_task *task);
+
+/**
+ * @brief Log the wakeup rate and the per-task lateness
+ */
+void coalesce_print(void);
+
+#endif /* CONFIG_APP_COALESCE */
+
+#ifdef CONFIG_APP_COALESCE_DEMO
+
+/**
+ * @brief Start the demo tasks (status, checkpoint, sync poll,
+ * watchdog feed) and a periodic report
+ */
+void coalesce_demo_start(void);
+
+#else
+
+static inline void coalesce_demo_start(void) {}
+
+#endif /* CONFIG_APP_COALESCE_DEMO */
+
+#endif /* COALESCE_H */
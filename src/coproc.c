@@ -0,0 +1,52 @@
+/*
+ * Coprocessor offload, application side
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <string.h>
+#include "coproc.h"
+#include "coproc_shm.h"
+
+void coproc_post_calibration(uint64_t utc_us, uint64_t grtc_us)
+{
+	struct coproc_shm *shm = COPROC_SHM;
+	unsigned int key = irq_lock();
+
+	coproc_seq_write_begin(&shm->cal.seq);
+	shm->cal.utc_us = utc_us;
+	shm->cal.grtc_us = grtc_us;
+	coproc_seq_write_end(&shm->cal.seq);
+
+	irq_unlock(key);
+}
+
+bool coproc_clock_get(struct coproc_clock *clock)
+{
+	const struct coproc_shm *shm = COPROC_SHM;
+	uint32_t seq;
+
+	do {
+		seq = coproc_seq_read_begin(&shm->clock.seq);
+		*clock = shm->clock.model;
+	} while (coproc_seq_read_retry(&shm->clock.seq, seq));
+
+	return clock->calibrated != 0U;
+}
+
+/* Clear the shared block before the trace hooks start recording
+ * (func_trace.c, PRE_KERNEL_2 priority 99) and before the
+ * coprocessor is launched.
+ */
+static int coproc_shm_init(void)
+{
+	struct coproc_shm *shm = COPROC_SHM;
+
+	memset(shm, 0, sizeof(*shm));
+	barrier_dmem_fence_full();
+	shm->magic = COPROC_SHM_MAGIC;
+
+	return 0;
+}
+
+SYS_INIT(coproc_shm_init, PRE_KERNEL_2, 98);
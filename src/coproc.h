@@ -0,0 +1,43 @@
+/*
+ * Coprocessor offload - Header File
+ *
+ * With CONFIG_APP_COPROC the RISC-V coprocessor (cpuflpr on nRF54L15)
+ * runs the clock filter on the calibration samples and drains the
+ * function trace ring (see coproc_shm.h and coproc/).  The application
+ * core only posts samples and reads the published clock model.
+ */
+
+#ifndef COPROC_H
+#define COPROC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct coproc_clock;
+
+#ifdef CONFIG_APP_COPROC
+
+/**
+ * @brief Hand a calibration sample to the coprocessor clock filter
+ *
+ * @param utc_us UTC timestamp in microseconds
+ * @param grtc_us GRTC value the timestamp was taken at
+ */
+void coproc_post_calibration(uint64_t utc_us, uint64_t grtc_us);
+
+/**
+ * @brief Read the clock model published by the coprocessor
+ *
+ * @param clock Output model, evaluate with coproc_clock_utc_us()
+ * @return true if the coprocessor has published a calibrated model
+ */
+bool coproc_clock_get(struct coproc_clock *clock);
+
+#else
+
+static inline void coproc_post_calibration(uint64_t utc_us, uint64_t grtc_us) {}
+static inline bool coproc_clock_get(struct coproc_clock *clock) { return false; }
+
+#endif /* CONFIG_APP_COPROC */
+
+#endif /* COPROC_H */
@@ -0,0 +1,125 @@
+/*
+ * Application core / coprocessor shared memory - Header File
+ *
+ * Layout of the app_shm devicetree region, shared by the application
+ * and the coprocessor image in coproc/.  Both cores map the region at
+ * the same address.  Every block has a single writer:
+ *
+ *  - cal:   calibration samples, application -> coprocessor
+ *  - clock: filtered clock model, coprocessor -> application
+ *  - trace: function trace ring, application -> coprocessor
+ *
+ * cal and clock are seqlocks: the writer makes seq odd, updates the
+ * block and makes seq even again; readers retry while seq is odd or
+ * changed under them.
+ */
+
+#ifndef COPROC_SHM_H
+#define COPROC_SHM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/barrier.h>
+
+#define COPROC_SHM_MAGIC      0x55544331 /* "UTC1" */
+#define COPROC_TRACE_EVENTS   256
+
+struct coproc_clock {
+	uint32_t calibrated;
+	uint32_t reserved;
+	/* UTC - GRTC in microseconds at ref_grtc */
+	int64_t offset_us;
+	uint64_t ref_grtc;
+	/* Rate error of the GRTC against UTC, in units of 2^-32 */
+	int64_t drift_q32;
+};
+
+struct coproc_trace_event {
+	uint32_t fn;
+	uint32_t stamp;         /* Same encoding as func_trace.c */
+};
+
+struct coproc_shm {
+	uint32_t magic;
+
+	struct {
+		volatile uint32_t seq;
+		uint32_t reserved;
+		uint64_t utc_us;
+		uint64_t grtc_us;
+	} cal;
+
+	struct {
+		volatile uint32_t seq;
+		uint32_t reserved;
+		struct coproc_clock model;
+	} clock;
+
+	struct {
+		volatile uint32_t head;     /* Written by the application */
+		volatile uint32_t tail;     /* Written by the coprocessor */
+		volatile uint32_t dropped;  /* Events lost while the ring was full */
+		volatile uint32_t flush;    /* Set by func_trace_dump(), cleared when drained */
+		struct coproc_trace_event events[COPROC_TRACE_EVENTS];
+	} trace;
+};
+
+#define COPROC_SHM_NODE DT_NODELABEL(app_shm)
+#define COPROC_SHM ((struct coproc_shm *)DT_REG_ADDR(COPROC_SHM_NODE))
+
+BUILD_ASSERT(sizeof(struct coproc_shm) <= DT_REG_SIZE(COPROC_SHM_NODE),
+	     "coproc_shm does not fit the app_shm region");
+BUILD_ASSERT((COPROC_TRACE_EVENTS & (COPROC_TRACE_EVENTS - 1)) == 0,
+	     "COPROC_TRACE_EVENTS must be a power of two");
+
+static inline void coproc_seq_write_begin(volatile uint32_t *seq)
+{
+	*seq = *seq + 1U;
+	barrier_dmem_fence_full();
+}
+
+static inline void coproc_seq_write_end(volatile uint32_t *seq)
+{
+	barrier_dmem_fence_full();
+	*seq = *seq + 1U;
+}
+
+static inline uint32_t coproc_seq_read_begin(const volatile uint32_t *seq)
+{
+	uint32_t start;
+
+	while ((start = *seq) & 1U) {
+	}
+	barrier_dmem_fence_full();
+
+	return start;
+}
+
+static inline bool coproc_seq_read_retry(const volatile uint32_t *seq, uint32_t start)
+{
+	barrier_dmem_fence_full();
+	return *seq != start;
+}
+
+/**
+ * @brief Evaluate the clock model at a GRTC value
+ *
+ * @param clock Snapshot of the model taken under clock.seq, so that
+ * offset, reference and drift belong to the same calibration
+ * @return UTC timestamp in microseconds
+ */
+static inline uint64_t coproc_clock_utc_us(const struct coproc_clock *clock, uint64_t grtc)
+{
+	int64_t elapsed = (int64_t)(grtc - clock->ref_grtc);
+
+	/* elapsed * drift would overflow after about 50 days at 500 ppm:
+	 * multiply the upper and lower 32 bits separately
+	 */
+	int64_t drift_us = (elapsed >> 32) * clock->drift_q32 +
+			   (((int64_t)(elapsed & 0xffffffff) * clock->drift_q32) >> 32);
+
+	return grtc + clock->offset_us + drift_us;
+}
+
+#endif /* COPROC_SHM_H */
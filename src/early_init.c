@@ -0,0 +1,100 @@
+/*
+ * Early restore of retained state and UTC
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+#include <zephyr/timing/timing.h>
+#include "early_init.h"
+#include "grtc.h"
+#include "utc_time.h"
+
+#if defined(CONFIG_NRF_GRTC_TIMER) && !defined(CONFIG_APP_GRTC_SIM)
+#include <hal/nrf_grtc.h>
+#define EARLY_INIT_SYSCOUNTER
+#endif
+
+LOG_MODULE_REGISTER(early_init, LOG_LEVEL_INF);
+
+#ifdef EARLY_INIT_SYSCOUNTER
+/* Bound on the SYSCOUNTERH reads while it wakes up (a few 32 kHz cycles) */
+#define SYSCOUNTER_WAKE_TRIES 10000
+
+/* The GRTC driver only makes the SYSCOUNTER active at PRE_KERNEL_2.
+ * Until then it may sleep, and while waking up its value reads as BUSY
+ * (SYSCOUNTERH) rather than as the count.  Request it active here; the
+ * driver takes the request over when it initializes.  After a
+ * power-on reset the counter is not started yet and reads as 0, which
+ * the restore treats as a GRTC restart.
+ */
+static void syscounter_wake(void)
+{
+	nrf_grtc_sys_counter_active_set(NRF_GRTC, true);
+
+	for (int i = 0; i < SYSCOUNTER_WAKE_TRIES; i++) {
+		if ((nrf_grtc_sys_counter_high_get(NRF_GRTC) &
+		     GRTC_SYSCOUNTER_SYSCOUNTERH_BUSY_Msk) == 0U) {
+			break;
+		}
+	}
+}
+#endif /* EARLY_INIT_SYSCOUNTER */
+
+static bool retained_valid;
+static int utc_restore_err;
+static uint64_t restore_cycles;
+
+#ifdef CONFIG_LOG
+static log_timestamp_t utc_log_timestamp(void)
+{
+	return utc_time_from_grtc(grtc_read_us());
+}
+#endif
+
+static int early_restore(void)
+{
+	timing_init();
+	timing_start();
+
+	timing_t start = timing_counter_get();
+
+#ifdef EARLY_INIT_SYSCOUNTER
+	/* Before the first GRTC read, the log timestamps included */
+	syscounter_wake();
+#endif
+	retained_valid = retained_validate();
+	utc_restore_err = utc_time_restore();
+
+	timing_t end = timing_counter_get();
+
+	restore_cycles = timing_cycles_get(&start, &end);
+
+#ifdef CONFIG_LOG
+	/* Raw GRTC microseconds until calibrated, UTC afterwards */
+	(void)log_set_timestamp_func(utc_log_timestamp, 1000000U);
+#endif
+
+	return 0;
+}
+
+SYS_INIT(early_restore, PRE_KERNEL_1, 0);
+
+bool early_init_retained_valid(void)
+{
+	return retained_valid;
+}
+
+void early_init_report(void)
+{
+	LOG_INF("Early restore: retained %s, UTC %s, %llu ns before the kernel",
+		retained_valid ? "valid" : "invalid",
+		utc_restore_err == 0 ? "restored" :
+		utc_restore_err == -ESTALE ? "stale (GRTC restarted)" : "not stored",
+		timing_cycles_to_ns(restore_cycles));
+
+	if (utc_restore_err != -ENOENT) {
+		utc_time_publish();
+	}
+}
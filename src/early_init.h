@@ -0,0 +1,41 @@
+/*
+ * Early restore of retained state and UTC - Header File
+ *
+ * With CONFIG_APP_EARLY_RESTORE a PRE_KERNEL_1 hook validates the
+ * retained data and restores the persisted UTC calibration before any
+ * driver initializes, then makes UTC the log timestamp source.  The
+ * first log line and everything drivers log during init are stamped
+ * with UTC after a soft reset.  The hook only reads RAM and the GRTC
+ * counter: the retained_mem driver and the GRTC driver are not up yet,
+ * so it requests the SYSCOUNTER active itself before reading it.
+ */
+
+#ifndef EARLY_INIT_H
+#define EARLY_INIT_H
+
+#include <stdbool.h>
+#include "retained.h"
+
+#ifdef CONFIG_APP_EARLY_RESTORE
+
+/**
+ * @brief Result of the early retained_validate()
+ *
+ * @return true if the retained data was valid at boot
+ */
+bool early_init_retained_valid(void);
+
+/**
+ * @brief Log what the hook restored and the time it took, and publish
+ * the restored clock now that the kernel runs
+ */
+void early_init_report(void);
+
+#else
+
+static inline bool early_init_retained_valid(void) { return retained_validate(); }
+static inline void early_init_report(void) {}
+
+#endif /* CONFIG_APP_EARLY_RESTORE */
+
+#endif /* EARLY_INIT_H */
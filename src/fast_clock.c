@@ -0,0 +1,207 @@
+/*
+ * Per-core fast clock
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+#include "fast_clock.h"
+#include "coalesce.h"
+
+#ifdef CONFIG_PM
+#include <zephyr/pm/pm.h>
+#endif
+
+LOG_MODULE_REGISTER(fast_clock, LOG_LEVEL_INF);
+
+struct fast_clock_ref {
+	timing_t cycles;
+	uint64_t grtc_us;
+	uint64_t us_per_cycle_q32;      /* Measured rate, units of 2^-32 us */
+};
+
+/* Double buffer: the resync fills refs[(gen + 1) & 1] and then bumps
+ * gen, so a reader interrupting it still sees a complete reference,
+ * and a reader that was interrupted by it retries.
+ */
+static struct fast_clock_ref refs[2];
+static atomic_t gen;
+static uint32_t max_error_us;
+static bool synced;
+
+#ifdef CONFIG_ARM_ON_ENTER_CPU_IDLE_HOOK
+/* Set right before WFI stops the cycle counter */
+static atomic_t idled;
+
+bool z_arm_on_enter_cpu_idle(void)
+{
+	atomic_set(&idled, 1);
+	return true;
+}
+
+/* True if the core may have slept since the last resync */
+static inline bool idled_take(void)
+{
+	return atomic_set(&idled, 0) != 0;
+}
+#else
+/* Idle cannot be seen: the rate is never measured across a resync
+ * period, it may have included a sleep.
+ */
+static inline bool idled_take(void)
+{
+	return true;
+}
+#endif /* CONFIG_ARM_ON_ENTER_CPU_IDLE_HOOK */
+
+#define RESYNC_US ((uint32_t)CONFIG_APP_FAST_CLOCK_RESYNC_MS * 1000U)
+
+#ifdef CONFIG_APP_COALESCE
+/* A quarter period of slack: the rate is measured over the actual
+ * period, which must stay below the cycle counter wrap
+ */
+static void resync_fn(struct coalesce_task *task);
+static COALESCE_TASK_DEFINE(clock_resync, resync_fn, RESYNC_US, RESYNC_US / 4U);
+#else
+static void resync_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(resync_work, resync_work_handler);
+#endif
+
+static inline uint64_t extrapolate(const struct fast_clock_ref *ref, timing_t now)
+{
+	timing_t start = ref->cycles;
+	uint64_t cycles = timing_cycles_get(&start, &now);
+
+	return ref->grtc_us + ((cycles * ref->us_per_cycle_q32) >> 32);
+}
+
+/* Extrapolate from the current reference, which is copied to ref */
+static uint64_t read_ref(struct fast_clock_ref *ref)
+{
+	atomic_val_t start;
+
+	do {
+		start = atomic_get(&gen);
+		*ref = refs[start & 1];
+	} while (atomic_get(&gen) != start);
+
+	return extrapolate(ref, timing_counter_get());
+}
+
+uint64_t fast_clock_get_us(void)
+{
+	struct fast_clock_ref ref;
+	uint64_t us = read_ref(&ref);
+
+#ifdef CONFIG_ARM_ON_ENTER_CPU_IDLE_HOOK
+	/* After a sleep, resync here only if the reference is older than
+	 * the resync period (as far as the counter saw); a younger one is
+	 * caught up by the periodic resync, which wakes the core at least
+	 * that often.
+	 */
+	if (atomic_get(&idled) != 0 && us - ref.grtc_us >= RESYNC_US) {
+		fast_clock_resync();
+		us = read_ref(&ref);
+	}
+#endif
+
+	return us;
+}
+
+uint64_t fast_clock_get_precise_us(void)
+{
+	return grtc_read_us();
+}
+
+void fast_clock_resync(void)
+{
+	/* Also keeps the two counter reads back to back */
+	unsigned int key = irq_lock();
+	atomic_val_t cur = atomic_get(&gen);
+	const struct fast_clock_ref *old = &refs[cur & 1];
+	struct fast_clock_ref *next = &refs[(cur + 1) & 1];
+	uint64_t grtc_us = grtc_read_us();
+	timing_t cycles = timing_counter_get();
+	bool idle = idled_take();
+
+	next->cycles = cycles;
+	next->grtc_us = grtc_us;
+	next->us_per_cycle_q32 = old->us_per_cycle_q32;
+
+	/* The counter stood still for part of a period with a sleep: its
+	 * extrapolation error and rate say nothing about the counter.
+	 */
+	if (synced && !idle) {
+		uint64_t predicted = extrapolate(old, cycles);
+		timing_t start = old->cycles;
+		uint64_t elapsed_cycles = timing_cycles_get(&start, &cycles);
+		uint64_t elapsed_us = grtc_us - old->grtc_us;
+		uint64_t error = (predicted > grtc_us) ? predicted - grtc_us : grtc_us - predicted;
+
+		max_error_us = MAX(max_error_us, (uint32_t)MIN(error, UINT32_MAX));
+
+		/* Re-measure the cycle counter rate against the GRTC */
+		if (elapsed_cycles != 0U && elapsed_us != 0U && elapsed_us < BIT64(31)) {
+			next->us_per_cycle_q32 = (elapsed_us << 32) / elapsed_cycles;
+		}
+	}
+
+	atomic_inc(&gen);
+	synced = true;
+	irq_unlock(key);
+}
+
+#ifdef CONFIG_PM
+/* The cycle counter stops while the core sleeps */
+static void pm_state_exit(enum pm_state state)
+{
+	ARG_UNUSED(state);
+	fast_clock_resync();
+}
+
+static struct pm_notifier fast_clock_notifier = {
+	.state_exit = pm_state_exit,
+};
+#endif /* CONFIG_PM */
+
+uint32_t fast_clock_max_error_us(void)
+{
+	return max_error_us;
+}
+
+#ifdef CONFIG_APP_COALESCE
+static void resync_fn(struct coalesce_task *task)
+{
+	ARG_UNUSED(task);
+	fast_clock_resync();
+}
+#else
+static void resync_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	fast_clock_resync();
+	k_work_schedule(&resync_work, K_MSEC(CONFIG_APP_FAST_CLOCK_RESYNC_MS));
+}
+#endif
+
+void fast_clock_init(void)
+{
+	timing_init();
+	timing_start();
+
+	/* Nominal rate until an idle-free resync period has been measured */
+	refs[atomic_get(&gen) & 1].us_per_cycle_q32 = BIT64(32) / timing_freq_get_mhz();
+
+#ifdef CONFIG_APP_COALESCE
+	fast_clock_resync();
+	coalesce_schedule_in(&clock_resync, RESYNC_US);
+#else
+	resync_work_handler(NULL);
+#endif
+#ifdef CONFIG_PM
+	pm_notifier_register(&fast_clock_notifier);
+#endif
+	LOG_INF("Fast clock: %u MHz cycle counter, resync every %u ms",
+		timing_freq_get_mhz(), CONFIG_APP_FAST_CLOCK_RESYNC_MS);
+}
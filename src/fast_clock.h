@@ -0,0 +1,85 @@
+/*
+ * Per-core fast clock - Header File
+ *
+ * On nRF54H20 the GRTC sits in the global domain and every
+ * grtc_read_us() is a slow bus access from cpuapp or cpuppr.  The fast
+ * clock extrapolates GRTC microseconds from the core's own cycle
+ * counter (timing API: DWT on Cortex-M33, mcycle on RISC-V) and
+ * resynchronizes with a real GRTC read every
+ * CONFIG_APP_FAST_CLOCK_RESYNC_MS.  Each resync also re-measures the
+ * cycle counter rate against the GRTC, so the error stays bounded by
+ * the rate wander over one resync period (see fast_clock_max_error_us()).
+ *
+ * The cycle counter only runs while the core does.  On Cortex-M the
+ * idle hook (CONFIG_ARM_ON_ENTER_CPU_IDLE_HOOK) flags every WFI; the
+ * rate is only re-measured over periods without a sleep, and a read
+ * after a sleep resyncs only if the reference is older than the
+ * resync period.  Until the next resync such reads lag the GRTC by
+ * the time slept, which is below the resync period.  On RISC-V there
+ * is no idle hook: the nominal rate is used throughout and is never
+ * re-measured, and low-power states resync on exit (CONFIG_PM); after
+ * plain idle call fast_clock_resync() before relying on the fast
+ * clock, or use it only within active bursts such as tracing and
+ * profiling.
+ */
+
+#ifndef FAST_CLOCK_H
+#define FAST_CLOCK_H
+
+#include <stdint.h>
+#include "grtc.h"
+
+#ifdef CONFIG_APP_FAST_CLOCK
+
+/**
+ * @brief Start the cycle counter and the periodic resync
+ */
+void fast_clock_init(void);
+
+/**
+ * @brief Read the extrapolated GRTC time
+ *
+ * Callable from any context.  Not guaranteed to be monotonic across a
+ * resync: it may step back by up to fast_clock_max_error_us().
+ *
+ * @return GRTC time in microseconds
+ */
+uint64_t fast_clock_get_us(void);
+
+/**
+ * @brief Read the GRTC directly
+ *
+ * For the cases that need full precision; same cost as grtc_read_us().
+ *
+ * @return GRTC time in microseconds
+ */
+uint64_t fast_clock_get_precise_us(void);
+
+/**
+ * @brief Resynchronize with the GRTC now
+ *
+ * Called by the periodic resync work and on PM state exit; callable
+ * from any context.
+ */
+void fast_clock_resync(void);
+
+/**
+ * @brief Largest extrapolation error seen at a resync
+ *
+ * Only resyncs that close a period without a sleep are counted.
+ *
+ * @return Error in microseconds since fast_clock_init()
+ */
+uint32_t fast_clock_max_error_us(void);
+
+#else
+
+static inline void fast_clock_init(void) {}
+static inline uint64_t fast_clock_get_us(void) { return grtc_read_us(); }
+static inline uint64_t fast_clock_get_precise_us(void) { return grtc_read_us(); }
+static inline void fast_clock_resync(void) {}
+static inline uint32_t fast_clock_max_error_us(void) { return 0; }
+
+#endif /* CONFIG_APP_FAST_CLOCK */
+
+#endif /* FAST_CLOCK_H */
@@ -0,0 +1,242 @@
+/*
+ * Retained storage fault injection
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+#include <zephyr/zbus/zbus.h>
+#include <string.h>
+#include "fault_inject.h"
+#include "latency_hist.h"
+#include "mono_time.h"
+#include "retained.h"
+
+LOG_MODULE_REGISTER(fault_inject, LOG_LEVEL_INF);
+
+/* Every commit would otherwise be logged */
+ZBUS_OBS_DECLARE(status_logger);
+
+/* A/B slots: the sequence number picks the newer valid copy.  They
+ * live in the histogram window, which is restored after the run.
+ */
+struct ab_slot {
+	uint32_t seq;
+	struct retained_data data;
+};
+
+#define AB_SLOT_STRIDE ROUND_UP(sizeof(struct ab_slot) + sizeof(uint32_t), 8)
+#define AB_SLOT_OFFSET(i) (RETAINED_HIST_OFFSET + (i) * AB_SLOT_STRIDE)
+
+BUILD_ASSERT(2 * AB_SLOT_STRIDE <= RETAINED_HIST_SIZE,
+	     "A/B slots do not fit the histogram window");
+
+struct storage_mode {
+	const char *name;
+	void (*commit)(void);
+	/* Reload retained from the region, false if nothing was valid */
+	bool (*recover)(void);
+	/* Bytes of the region the stored copies occupy */
+	size_t offset;
+	size_t size;
+};
+
+enum fault_kind {
+	FAULT_TORN,
+	FAULT_BIT_FLIP,
+};
+
+static uint32_t ab_seq;
+
+static uint8_t region_backup[4096];
+static struct retained_data retained_backup;
+
+static uint32_t xorshift_state = 2463534242U;
+
+static uint32_t fault_rand(void)
+{
+	xorshift_state ^= xorshift_state << 13;
+	xorshift_state ^= xorshift_state >> 17;
+	xorshift_state ^= xorshift_state << 5;
+	return xorshift_state;
+}
+
+static void in_place_commit(void)
+{
+	retained_update();
+}
+
+static bool in_place_recover(void)
+{
+	return retained_validate();
+}
+
+static void ab_commit(void)
+{
+	struct ab_slot slot = {
+		.seq = ++ab_seq,
+		.data = retained,
+	};
+
+	(void)retained_blob_write(AB_SLOT_OFFSET(slot.seq & 1U), &slot, sizeof(slot));
+}
+
+static bool ab_recover(void)
+{
+	struct ab_slot slot[2];
+	bool valid[2];
+
+	for (int i = 0; i < 2; i++) {
+		valid[i] = (retained_blob_read(AB_SLOT_OFFSET(i), &slot[i],
+					       sizeof(slot[i])) == 0);
+	}
+
+	/* Serial number comparison, the sequence may wrap */
+	int pick = (valid[0] && (!valid[1] || (int32_t)(slot[0].seq - slot[1].seq) > 0)) ? 0 : 1;
+
+	if (!valid[pick]) {
+		memset(&retained, 0, sizeof(retained));
+		ab_seq = 0;
+		return false;
+	}
+
+	retained = slot[pick].data;
+	ab_seq = slot[pick].seq;
+	return true;
+}
+
+static const struct storage_mode modes[] = {
+	{
+		.name = "in-place",
+		.commit = in_place_commit,
+		.recover = in_place_recover,
+		.offset = 0,
+		.size = offsetof(struct retained_data, crc) + sizeof(uint32_t),
+	},
+	{
+		.name = "A/B",
+		.commit = ab_commit,
+		.recover = ab_recover,
+		.offset = AB_SLOT_OFFSET(0),
+		.size = AB_SLOT_STRIDE + sizeof(struct ab_slot) + sizeof(uint32_t),
+	},
+};
+
+static void flip_bit(size_t offset, size_t size)
+{
+	size_t region_size;
+	uint8_t *region = (uint8_t *)retained_region_view(&region_size);
+	uint32_t bit = fault_rand() % (size * 8U);
+
+	/* The emulated region is process memory */
+	region[offset + bit / 8U] ^= BIT(bit % 8U);
+}
+
+static LATENCY_HIST_DEFINE(recovery_hist);
+
+static void run(const struct storage_mode *mode, enum fault_kind kind)
+{
+	uint32_t recovered = 0;
+	uint32_t wiped = 0;
+	uint32_t mismatched = 0;
+	uint64_t lost_sum = 0;
+	uint32_t lost_max = 0;
+	size_t commit_bytes;
+
+	/* Start from a committed, empty state */
+	memset(&retained, 0, sizeof(retained));
+	ab_seq = 0;
+	mode->commit();
+	mode->commit();
+
+	/* Size of one commit, to place the tear anywhere inside it */
+	(void)retained_fault_arm(-1);
+	mode->commit();
+	commit_bytes = retained_fault_arm(-1);
+
+	latency_hist_reset(&recovery_hist);
+
+	for (int i = 0; i < CONFIG_APP_FAULT_INJECT_CYCLES; i++) {
+		uint32_t expected = retained.boots + 1U;
+
+		retained.boots = expected;
+		if (kind == FAULT_TORN) {
+			(void)retained_fault_arm(fault_rand() % (commit_bytes + 1U));
+			mode->commit();
+			(void)retained_fault_arm(-1);
+		} else {
+			mode->commit();
+			flip_bit(mode->offset, mode->size);
+		}
+
+		/* Reset: the RAM copy is gone */
+		memset(&retained, 0xa5, sizeof(retained));
+
+		timing_t start = timing_counter_get();
+		bool valid = mode->recover();
+		timing_t end = timing_counter_get();
+
+		latency_hist_record(&recovery_hist, (uint32_t)timing_cycles_get(&start, &end));
+
+		/* A wiped store loses everything; otherwise the loss
+		 * window is the commits missing from what was recovered:
+		 * 0, or 1 if the interrupted commit did not make it.
+		 */
+		if (!valid) {
+			wiped++;
+			continue;
+		}
+
+		uint32_t lost = (retained.boots < expected) ? expected - retained.boots : 0U;
+
+		if (lost <= 1U && retained.boots <= expected) {
+			recovered++;
+		} else {
+			/* Passed validation with wrong contents */
+			mismatched++;
+		}
+		lost_sum += lost;
+		lost_max = MAX(lost_max, lost);
+	}
+
+	uint32_t survived = MAX(recovered + mismatched, 1U);
+
+	LOG_INF("%-8s %-8s recovered %5u/%u (%3u%%), wiped %u, corrupt %u",
+		mode->name, kind == FAULT_TORN ? "torn" : "bit flip", recovered,
+		CONFIG_APP_FAULT_INJECT_CYCLES,
+		(uint32_t)(100ULL * recovered / CONFIG_APP_FAULT_INJECT_CYCLES),
+		wiped, mismatched);
+	LOG_INF("%-8s %-8s loss window mean %llu.%02llu max %u commits, "
+		"recovery p50 %llu p99 %llu ns", "", "",
+		lost_sum / survived, (lost_sum * 100U / survived) % 100U, lost_max,
+		timing_cycles_to_ns(latency_hist_percentile(&recovery_hist, 500)),
+		timing_cycles_to_ns(latency_hist_percentile(&recovery_hist, 990)));
+}
+
+void fault_inject_run(void)
+{
+	size_t region_size;
+	const uint8_t *region = retained_region_view(&region_size);
+
+	__ASSERT_NO_MSG(region_size <= sizeof(region_backup));
+	memcpy(region_backup, region, region_size);
+	retained_backup = retained;
+
+	timing_init();
+	timing_start();
+	(void)zbus_obs_set_enable(&status_logger, false);
+
+	LOG_INF("=== Fault injection (%u cycles per run) ===", CONFIG_APP_FAULT_INJECT_CYCLES);
+	for (size_t m = 0; m < ARRAY_SIZE(modes); m++) {
+		run(&modes[m], FAULT_TORN);
+		run(&modes[m], FAULT_BIT_FLIP);
+	}
+
+	(void)zbus_obs_set_enable(&status_logger, true);
+
+	memcpy((uint8_t *)region, region_backup, region_size);
+	retained = retained_backup;
+
+	/* The restored lease horizon is older than the clock */
+	mono_time_update();
+}
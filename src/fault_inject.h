@@ -0,0 +1,37 @@
+/*
+ * Retained storage fault injection - Header File
+ *
+ * native_sim harness that runs CONFIG_APP_FAULT_INJECT_CYCLES
+ * simulated commit / reset / recover cycles per storage mode and fault
+ * kind:
+ *
+ *   torn     - the commit is cut off after a random number of bytes
+ *              (retained_fault_arm()), then the device "resets"
+ *   bit flip - one random bit of the stored copy flips after a
+ *              complete commit, then the device "resets"
+ *
+ * The modes are the in-place struct retained_data store
+ * (retained_update() / retained_validate()) and, as a reference for a
+ * redundant scheme, an A/B pair of sequence-numbered blobs.  For each
+ * run it logs the recovery rate, the data-loss window in commits and
+ * the recovery time.  The region and the retained data are restored
+ * afterwards.
+ */
+
+#ifndef FAULT_INJECT_H
+#define FAULT_INJECT_H
+
+#ifdef CONFIG_APP_FAULT_INJECT
+
+/**
+ * @brief Run all modes and fault kinds and log the results
+ */
+void fault_inject_run(void);
+
+#else
+
+static inline void fault_inject_run(void) {}
+
+#endif /* CONFIG_APP_FAULT_INJECT */
+
+#endif /* FAULT_INJECT_H */
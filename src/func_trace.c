@@ -0,0 +1,156 @@
+/*
+ * Compiler-driven function tracing
+ *
+ * This file must not be built with -finstrument-functions itself; the
+ * hooks are also marked no_instrument_function for safety.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/printk.h>
+#include "func_trace.h"
+#include "grtc.h"
+#ifdef CONFIG_APP_COPROC
+#include "coproc_shm.h"
+#endif
+
+#define FUNC_TRACE_EVENTS CONFIG_APP_FUNC_TRACE_EVENTS
+
+BUILD_ASSERT((FUNC_TRACE_EVENTS & (FUNC_TRACE_EVENTS - 1)) == 0,
+	     "CONFIG_APP_FUNC_TRACE_EVENTS must be a power of two");
+
+/* Bit 31 of stamp marks an exit, bits 0..30 hold GRTC microseconds
+ * (wrapping every ~35 minutes, long enough for any boot path).
+ */
+#define FUNC_TRACE_EXIT  BIT(31)
+#define FUNC_TRACE_US    (FUNC_TRACE_EXIT - 1U)
+
+struct func_trace_event {
+	uintptr_t fn;
+	uint32_t stamp;
+};
+
+static atomic_t enabled;
+
+#ifdef CONFIG_APP_COPROC
+/* Stream into the shared ring; the coprocessor drains and prints it
+ * (coproc/src/main.c), so nothing is lost to wrap-around unless the
+ * coprocessor falls behind, which is counted in trace.dropped.
+ */
+__attribute__((no_instrument_function))
+static inline void func_trace_record(void *fn, uint32_t exit)
+{
+	if (!atomic_get(&enabled)) {
+		return;
+	}
+
+	struct coproc_shm *shm = COPROC_SHM;
+	unsigned int key = irq_lock();
+	uint32_t head = shm->trace.head;
+
+	if (head - shm->trace.tail >= COPROC_TRACE_EVENTS) {
+		shm->trace.dropped++;
+	} else {
+		struct coproc_trace_event *ev =
+			&shm->trace.events[head & (COPROC_TRACE_EVENTS - 1U)];
+
+		ev->fn = (uint32_t)(uintptr_t)fn;
+		ev->stamp = ((uint32_t)grtc_read_us() & FUNC_TRACE_US) | exit;
+		barrier_dmem_fence_full();
+		shm->trace.head = head + 1U;
+	}
+
+	irq_unlock(key);
+}
+#else
+static struct func_trace_event events[FUNC_TRACE_EVENTS];
+static atomic_t head;
+
+__attribute__((no_instrument_function))
+static inline void func_trace_record(void *fn, uint32_t exit)
+{
+	if (!atomic_get(&enabled)) {
+		return;
+	}
+
+	uint32_t slot = (uint32_t)atomic_inc(&head) & (FUNC_TRACE_EVENTS - 1U);
+
+	events[slot].fn = (uintptr_t)fn;
+	events[slot].stamp = ((uint32_t)grtc_read_us() & FUNC_TRACE_US) | exit;
+}
+#endif /* CONFIG_APP_COPROC */
+
+__attribute__((no_instrument_function))
+void __cyg_profile_func_enter(void *fn, void *call_site)
+{
+	ARG_UNUSED(call_site);
+	func_trace_record(fn, 0);
+}
+
+__attribute__((no_instrument_function))
+void __cyg_profile_func_exit(void *fn, void *call_site)
+{
+	ARG_UNUSED(call_site);
+	func_trace_record(fn, FUNC_TRACE_EXIT);
+}
+
+void func_trace_enable(bool enable)
+{
+	atomic_set(&enabled, enable ? 1 : 0);
+}
+
+#ifdef CONFIG_APP_COPROC
+void func_trace_dump(void)
+{
+	/* The coprocessor prints "FT END" once it has drained the ring */
+	COPROC_SHM->trace.flush = 1U;
+}
+
+const void *func_trace_ring(size_t *count, size_t *event_size, uint32_t *recorded)
+{
+	*count = 0;
+	*event_size = 0;
+	*recorded = 0;
+	return NULL;
+}
+#else
+const void *func_trace_ring(size_t *count, size_t *event_size, uint32_t *recorded)
+{
+	*count = FUNC_TRACE_EVENTS;
+	*event_size = sizeof(events[0]);
+	*recorded = (uint32_t)atomic_get(&head);
+	return events;
+}
+
+void func_trace_dump(void)
+{
+	uint32_t end = (uint32_t)atomic_get(&head);
+	uint32_t count = MIN(end, FUNC_TRACE_EVENTS);
+	bool was_enabled = atomic_set(&enabled, 0) != 0;
+
+	/* Host script input: one "FT <E|X> <address> <us>" line per event */
+	printk("FT BEGIN %u %u\n", count, end - count);
+	for (uint32_t i = end - count; i != end; i++) {
+		const struct func_trace_event *ev = &events[i & (FUNC_TRACE_EVENTS - 1U)];
+
+		printk("FT %c %08lx %u\n",
+		       (ev->stamp & FUNC_TRACE_EXIT) ? 'X' : 'E',
+		       (unsigned long)ev->fn, ev->stamp & FUNC_TRACE_US);
+	}
+	printk("FT END\n");
+
+	atomic_clear(&head);
+	func_trace_enable(was_enabled);
+}
+#endif /* CONFIG_APP_COPROC */
+
+/* Start recording once the GRTC (system timer, PRE_KERNEL_2 priority
+ * CONFIG_SYSTEM_CLOCK_INIT_PRIORITY) is running.
+ */
+static int func_trace_init(void)
+{
+	func_trace_enable(true);
+	return 0;
+}
+
+SYS_INIT(func_trace_init, PRE_KERNEL_2, 99);
@@ -0,0 +1,60 @@
+/*
+ * Compiler-driven function tracing - Header File
+ *
+ * Files built with -finstrument-functions (see CMakeLists.txt) call
+ * __cyg_profile_func_enter/exit on every function entry and exit.
+ * Those hooks store the function address and the raw GRTC counter in
+ * a RAM ring buffer; func_trace_dump() prints it for
+ * scripts/func_trace_flamegraph.py.  With CONFIG_APP_COPROC the ring
+ * is in shared memory and the coprocessor streams it to its own
+ * console instead.
+ */
+
+#ifndef FUNC_TRACE_H
+#define FUNC_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CONFIG_APP_FUNC_TRACE
+
+/**
+ * @brief Start or stop recording
+ *
+ * Recording starts automatically once the GRTC driver is up.
+ *
+ * @param enable true to record events
+ */
+void func_trace_enable(bool enable);
+
+/**
+ * @brief Print the recorded events, oldest first, and clear the buffer
+ *
+ * Recording is paused while dumping.  With CONFIG_APP_COPROC this
+ * only asks the coprocessor to close the current trace once drained.
+ */
+void func_trace_dump(void);
+
+/**
+ * @brief Direct view of the trace ring, for zero-copy readers
+ *
+ * Events are { uintptr_t fn; uint32_t stamp; } (see func_trace.c);
+ * event number n is at index n % *count.  With CONFIG_APP_COPROC the
+ * ring is streamed out by the coprocessor and this returns NULL.
+ *
+ * @param count Set to the ring size in events
+ * @param event_size Set to the size of one event in bytes
+ * @param recorded Set to the number of events recorded since the last dump
+ * @return Start of the ring
+ */
+const void *func_trace_ring(size_t *count, size_t *event_size, uint32_t *recorded);
+
+#else
+
+static inline void func_trace_enable(bool enable) {}
+static inline void func_trace_dump(void) {}
+
+#endif /* CONFIG_APP_FUNC_TRACE */
+
+#endif /* FUNC_TRACE_H */
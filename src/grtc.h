@@ -0,0 +1,64 @@
+/*
+ * GRTC system counter access
+ *
+ * The application reads the GRTC through grtc_read_us() so that it
+ * also builds for native_sim, where there is no GRTC and the counter
+ * is emulated from the kernel uptime (1 MHz, starting at boot).
+ *
+ * With CONFIG_APP_GRTC_SIM the counter is simulated instead
+ * (grtc_sim.c): the kernel uptime, taken as true time, run through a
+ * settable frequency error and restartable like the GRTC after a
+ * watchdog or power-on reset.
+ */
+
+#ifndef GRTC_H
+#define GRTC_H
+
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_NRF_GRTC_TIMER)
+#include <zephyr/drivers/timer/nrf_grtc_timer.h>
+#endif
+
+#include "input_rec.h"
+
+#ifdef CONFIG_APP_GRTC_SIM
+/**
+ * @brief Read the simulated counter
+ */
+uint64_t grtc_sim_read_us(void);
+
+/**
+ * @brief Set the frequency error of the simulated counter
+ *
+ * @param ppb Error in parts per billion, positive runs fast
+ */
+void grtc_sim_set_ppb(int32_t ppb);
+
+/**
+ * @brief Restart the simulated counter from 0
+ */
+void grtc_sim_restart(void);
+#endif
+
+/**
+ * @brief Read the GRTC system counter
+ *
+ * @return Counter value in microseconds
+ */
+__attribute__((no_instrument_function))
+static inline uint64_t grtc_read_us(void)
+{
+#if defined(CONFIG_APP_GRTC_SIM)
+	uint64_t value = grtc_sim_read_us();
+#elif defined(CONFIG_NRF_GRTC_TIMER)
+	uint64_t value = z_nrf_grtc_timer_read();
+#else
+	uint64_t value = k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+
+	/* Recorded or replayed inside recorded calls (input_rec.h) */
+	return input_rec_value(INPUT_REC_GRTC, value);
+}
+
+#endif /* GRTC_H */
@@ -0,0 +1,58 @@
+/*
+ * Simulated GRTC counter
+ */
+
+#include <zephyr/kernel.h>
+#include "grtc.h"
+
+/* Simulated counter at the kernel uptime ref_us; the rate since then
+ * is 1 + ppb / 10^9.
+ */
+static uint64_t sim_us;
+static uint64_t ref_us;
+static int32_t rate_ppb;
+
+__attribute__((no_instrument_function))
+static uint64_t true_us(void)
+{
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+__attribute__((no_instrument_function))
+static uint64_t sim_at(uint64_t now)
+{
+	int64_t dt = (int64_t)(now - ref_us);
+
+	return sim_us + dt + dt * rate_ppb / 1000000000;
+}
+
+__attribute__((no_instrument_function))
+uint64_t grtc_sim_read_us(void)
+{
+	unsigned int key = irq_lock();
+	uint64_t value = sim_at(true_us());
+
+	irq_unlock(key);
+	return value;
+}
+
+void grtc_sim_set_ppb(int32_t ppb)
+{
+	unsigned int key = irq_lock();
+	uint64_t now = true_us();
+
+	/* Fold the time at the old rate in first */
+	sim_us = sim_at(now);
+	ref_us = now;
+	rate_ppb = ppb;
+	irq_unlock(key);
+}
+
+void grtc_sim_restart(void)
+{
+	unsigned int key = irq_lock();
+
+	sim_us = 0;
+	ref_us = true_us();
+	irq_unlock(key);
+}
@@ -0,0 +1,50 @@
+/*
+ * GRTC compare triggers
+ */
+
+#include <zephyr/kernel.h>
+#include <helpers/nrfx_gppi.h>
+#include "grtc_trigger.h"
+
+int grtc_trigger_init(struct grtc_trigger *trigger, uint32_t task_addr)
+{
+	trigger->chan = z_nrf_grtc_timer_chan_alloc();
+	if (trigger->chan < 0) {
+		return -ENOMEM;
+	}
+
+	if (nrfx_gppi_channel_alloc(&trigger->ppi) != NRFX_SUCCESS) {
+		z_nrf_grtc_timer_chan_free(trigger->chan);
+		return -ENOMEM;
+	}
+
+	trigger->task_addr = task_addr;
+	nrfx_gppi_channel_endpoints_setup(trigger->ppi,
+					  z_nrf_grtc_timer_compare_evt_address_get(trigger->chan),
+					  task_addr);
+	nrfx_gppi_channels_enable(BIT(trigger->ppi));
+
+	return 0;
+}
+
+int grtc_trigger_arm(struct grtc_trigger *trigger, uint64_t grtc_us,
+		     z_nrf_grtc_timer_compare_handler_t handler, void *user_data)
+{
+	return z_nrf_grtc_timer_set(trigger->chan, grtc_us, handler, user_data);
+}
+
+void grtc_trigger_cancel(struct grtc_trigger *trigger)
+{
+	z_nrf_grtc_timer_abort(trigger->chan);
+}
+
+void grtc_trigger_release(struct grtc_trigger *trigger)
+{
+	z_nrf_grtc_timer_abort(trigger->chan);
+	nrfx_gppi_channels_disable(BIT(trigger->ppi));
+	nrfx_gppi_channel_endpoints_clear(trigger->ppi,
+					  z_nrf_grtc_timer_compare_evt_address_get(trigger->chan),
+					  trigger->task_addr);
+	(void)nrfx_gppi_channel_free(trigger->ppi);
+	z_nrf_grtc_timer_chan_free(trigger->chan);
+}
@@ -0,0 +1,58 @@
+/*
+ * GRTC compare triggers - Header File
+ *
+ * A trigger owns one GRTC compare channel and one (D)PPI channel that
+ * connects the compare event to a peripheral task.  Once armed, the
+ * task fires when the GRTC reaches the compare value, with no CPU
+ * involvement and therefore no interrupt latency or jitter.  The
+ * optional handler runs afterwards from the GRTC interrupt, e.g. to
+ * re-arm.  Used by the 1PPS output (pps.c) and the UTC triggers
+ * (utc_trigger.c).
+ */
+
+#ifndef GRTC_TRIGGER_H
+#define GRTC_TRIGGER_H
+
+#include <stdint.h>
+#include <zephyr/drivers/timer/nrf_grtc_timer.h>
+
+struct grtc_trigger {
+	int32_t chan;           /* GRTC compare channel */
+	uint8_t ppi;            /* (D)PPI channel, via nrfx_gppi */
+	uint32_t task_addr;
+};
+
+/**
+ * @brief Allocate the channels and connect the compare event to a task
+ *
+ * @param trigger Trigger to set up
+ * @param task_addr Address of the peripheral task register
+ * @return 0 on success, -ENOMEM if no GRTC or PPI channel is free
+ */
+int grtc_trigger_init(struct grtc_trigger *trigger, uint32_t task_addr);
+
+/**
+ * @brief Fire the task when the GRTC reaches a value
+ *
+ * Replaces any pending compare.  A value in the past fires at once.
+ *
+ * @param trigger Trigger from grtc_trigger_init()
+ * @param grtc_us GRTC value (1 MHz ticks)
+ * @param handler Called from the GRTC interrupt after the compare, or NULL
+ * @param user_data Passed to @p handler
+ * @return 0 on success, negative errno from the GRTC driver otherwise
+ */
+int grtc_trigger_arm(struct grtc_trigger *trigger, uint64_t grtc_us,
+		     z_nrf_grtc_timer_compare_handler_t handler, void *user_data);
+
+/**
+ * @brief Cancel a pending compare
+ */
+void grtc_trigger_cancel(struct grtc_trigger *trigger);
+
+/**
+ * @brief Disconnect and free the channels
+ */
+void grtc_trigger_release(struct grtc_trigger *trigger);
+
+#endif /* GRTC_TRIGGER_H */
@@ -0,0 +1,705 @@
+/*
+ * Record / replay of timekeeping inputs
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include "input_rec.h"
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+#include <zephyr/linker/section_tags.h>
+#endif
+
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+#include <zephyr/timing/timing.h>
+#include <zephyr/zbus/zbus.h>
+#include "retained.h"
+#include "utc_time.h"
+#endif
+
+LOG_MODULE_REGISTER(input_rec, LOG_LEVEL_INF);
+
+/* Stream layout: struct rec_header, then records of a tag byte and a
+ * payload.  Values are stored as the zigzag varint of the difference
+ * to the previous value of the same kind; the reset marker restarts
+ * the differences from 0 (the encoder's state did not survive).
+ */
+#define REC_MAGIC        0x31434552U  /* "REC1" */
+#define REC_VERSION      1U
+#define REC_FLAG_FULL    BIT(0)
+
+#define TAG_RESET        0x01U
+#define TAG_CALL         0x10U  /* | call, arg */
+#define TAG_INPUT        0x20U  /* | input, value */
+#define TAG_BYTES        0x30U  /* | input, offset, length, bytes */
+#define TAG_RESULT       0x40U  /* result */
+#define TAG_KIND(tag)    ((tag) & 0xf0U)
+#define TAG_INDEX(tag)   ((tag) & 0x0fU)
+
+#define VARINT_MAX       10U
+
+struct rec_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t flags;
+	uint32_t len;      /* bytes of records after the header */
+	uint32_t skipped;  /* calls made during another thread's call */
+};
+
+/* Previous value per kind */
+struct rec_codec {
+	uint64_t input[INPUT_REC_INPUTS];
+	uint64_t arg;
+	uint64_t result;
+};
+
+static struct rec_codec codec;
+
+/* The call in progress: depth > 0 in thread owner */
+static struct k_spinlock lock;
+static k_tid_t owner;
+static uint32_t depth;
+
+__attribute__((no_instrument_function))
+static k_tid_t self(void)
+{
+	return k_is_pre_kernel() ? NULL : k_current_get();
+}
+
+__attribute__((no_instrument_function))
+static bool in_call(void)
+{
+	return depth != 0U && !k_is_in_isr() && owner == self();
+}
+
+static uint64_t zigzag(uint64_t value, uint64_t last)
+{
+	int64_t d = (int64_t)(value - last);
+
+	return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+}
+
+static uint64_t unzigzag(uint64_t z, uint64_t last)
+{
+	return last + (uint64_t)((int64_t)(z >> 1) ^ -(int64_t)(z & 1U));
+}
+
+static bool enter(void)
+{
+	k_spinlock_key_t key;
+	bool outer = false;
+
+	if (k_is_in_isr()) {
+		return false;
+	}
+
+	key = k_spin_lock(&lock);
+	if (depth == 0U) {
+		owner = self();
+		depth = 1U;
+		outer = true;
+	} else if (owner == self()) {
+		depth++;
+	}
+	k_spin_unlock(&lock, key);
+
+	return outer;
+}
+
+/* True if this ends the outer call */
+static bool leave(void)
+{
+	if (!in_call()) {
+		return false;
+	}
+
+	return --depth == 0U;
+}
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+
+/* Survives soft and watchdog resets; validated by the header */
+static __noinit struct {
+	struct rec_header hdr;
+	uint8_t data[CONFIG_APP_INPUT_REC_BUFFER_SIZE];
+} stream;
+
+static bool started;
+static uint32_t calls;
+
+static size_t put_varint(uint8_t *p, uint64_t value)
+{
+	size_t n = 0;
+
+	while (value >= 0x80U) {
+		p[n++] = (uint8_t)value | 0x80U;
+		value >>= 7;
+	}
+	p[n++] = (uint8_t)value;
+
+	return n;
+}
+
+/* Space for a record of up to @p n bytes, NULL once the buffer is full */
+static uint8_t *reserve(size_t n)
+{
+	if (stream.hdr.flags & REC_FLAG_FULL) {
+		return NULL;
+	}
+	if (n > sizeof(stream.data) - stream.hdr.len) {
+		stream.hdr.flags |= REC_FLAG_FULL;
+		return NULL;
+	}
+
+	return &stream.data[stream.hdr.len];
+}
+
+/* Publish a record: a reset before this drops it whole */
+static void commit(size_t n)
+{
+	stream.hdr.len += n;
+}
+
+static void put_value(uint8_t tag, uint64_t *last, uint64_t value)
+{
+	uint8_t *p = reserve(1U + VARINT_MAX);
+
+	if (p != NULL) {
+		p[0] = tag;
+		commit(1U + put_varint(&p[1], zigzag(value, *last)));
+		*last = value;
+	}
+}
+
+/* First call of this boot: continue a valid stream or start anew */
+static void start(void)
+{
+	uint8_t *p;
+
+	started = true;
+	if (stream.hdr.magic != REC_MAGIC || stream.hdr.version != REC_VERSION ||
+	    stream.hdr.len > sizeof(stream.data)) {
+		stream.hdr = (struct rec_header){
+			.magic = REC_MAGIC,
+			.version = REC_VERSION,
+		};
+	}
+
+	p = reserve(1U);
+	if (p != NULL) {
+		p[0] = TAG_RESET;
+		commit(1U);
+	}
+}
+
+static void record_begin(enum input_rec_call call, uint64_t arg)
+{
+	if (!enter()) {
+		/* Another thread's call is being recorded */
+		if (!k_is_in_isr() && owner != self()) {
+			stream.hdr.skipped++;
+		}
+		return;
+	}
+
+	if (!started) {
+		start();
+	}
+	calls++;
+	put_value(TAG_CALL | call, &codec.arg, arg);
+}
+
+static uint64_t record_end(uint64_t result)
+{
+	if (leave()) {
+		put_value(TAG_RESULT, &codec.result, result);
+	}
+
+	return result;
+}
+
+__attribute__((no_instrument_function))
+static uint64_t record_value(enum input_rec_input input, uint64_t value)
+{
+	if (in_call()) {
+		put_value(TAG_INPUT | input, &codec.input[input], value);
+	}
+
+	return value;
+}
+
+static void record_bytes(enum input_rec_input input, size_t offset, void *data, size_t len)
+{
+	uint8_t *p;
+	size_t n = 1U;
+
+	if (!in_call()) {
+		return;
+	}
+
+	p = reserve(1U + 2U * VARINT_MAX + len);
+	if (p != NULL) {
+		p[0] = TAG_BYTES | input;
+		n += put_varint(&p[n], offset);
+		n += put_varint(&p[n], len);
+		memcpy(&p[n], data, len);
+		commit(n + len);
+	}
+}
+
+const uint8_t *input_rec_stream(size_t *size)
+{
+	*size = sizeof(stream.hdr) + stream.hdr.len;
+	return (const uint8_t *)&stream;
+}
+
+void input_rec_print(void)
+{
+	LOG_INF("Input recording: %u of %u bytes%s, %u calls this boot, %u skipped",
+		stream.hdr.len, (uint32_t)sizeof(stream.data),
+		(stream.hdr.flags & REC_FLAG_FULL) ? " (full)" : "", calls,
+		stream.hdr.skipped);
+}
+
+#endif /* CONFIG_APP_INPUT_REC_RECORD */
+
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+
+/* Limits of one call's inputs; a longer call stops the replay */
+#define FRAME_VALUES  32U
+#define FRAME_BYTES   8U
+
+/* Log this many differing results in full */
+#define MISMATCH_LOG_MAX 8U
+
+ZBUS_OBS_DECLARE(status_logger);
+
+static const char *const call_names[INPUT_REC_CALLS] = {
+	[INPUT_REC_CALL_VALIDATE] = "validate",
+	[INPUT_REC_CALL_UPDATE] = "update",
+	[INPUT_REC_CALL_RESTORE] = "restore",
+	[INPUT_REC_CALL_CALIBRATE] = "calibrate",
+	[INPUT_REC_CALL_GET_US] = "get_us",
+	[INPUT_REC_CALL_INVALIDATE] = "invalidate",
+};
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+/* No file: the stream recorded so far in this run is replayed */
+#else
+static const uint8_t replay_file[] = {
+#include "input_replay.inc"
+};
+#endif
+
+static const uint8_t *replay_data;
+static size_t replay_size;
+
+/* Inputs and result of the outer call being replayed */
+static struct {
+	uint64_t values[INPUT_REC_INPUTS][FRAME_VALUES];
+	uint8_t count[INPUT_REC_INPUTS];
+	uint8_t used[INPUT_REC_INPUTS];
+	struct {
+		uint8_t input;
+		uint32_t offset;
+		uint32_t len;
+		const uint8_t *data;
+		bool used;
+	} bytes[FRAME_BYTES];
+	uint8_t bytes_count;
+	enum input_rec_call call;
+	size_t at;        /* stream offset of the call record */
+	uint64_t result;
+	bool live;        /* a call the recording does not have */
+} frame;
+
+static bool replaying;
+static bool resetting;
+static k_tid_t driver;
+static size_t pos;
+static size_t end;
+static bool broken;
+
+static struct {
+	uint32_t matched;
+	uint32_t differed;
+	uint32_t unrecorded;  /* calls made here but not in the stream */
+	uint32_t extra;       /* inputs read beyond the recorded ones */
+	uint32_t unused;      /* recorded inputs not read */
+	uint32_t resets;
+	uint32_t calls[INPUT_REC_CALLS];
+	uint64_t cycles[INPUT_REC_CALLS];
+} replay;
+
+static bool get_varint(size_t *at, uint64_t *value)
+{
+	*value = 0;
+	for (unsigned int shift = 0; shift < 64U; shift += 7U) {
+		if (*at >= end) {
+			return false;
+		}
+
+		uint8_t b = replay_data[(*at)++];
+
+		*value |= (uint64_t)(b & 0x7fU) << shift;
+		if ((b & 0x80U) == 0U) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Decode the call at pos up to and including its result */
+static bool frame_load(void)
+{
+	uint64_t z;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.call = TAG_INDEX(replay_data[pos]);
+	frame.at = pos++;
+	if (!get_varint(&pos, &z)) {
+		return false;
+	}
+	codec.arg = unzigzag(z, codec.arg);
+
+	while (pos < end) {
+		uint8_t tag = replay_data[pos++];
+
+		if (TAG_KIND(tag) == TAG_INPUT && TAG_INDEX(tag) < INPUT_REC_INPUTS) {
+			uint8_t input = TAG_INDEX(tag);
+
+			if (!get_varint(&pos, &z) || frame.count[input] == FRAME_VALUES) {
+				return false;
+			}
+			codec.input[input] = unzigzag(z, codec.input[input]);
+			frame.values[input][frame.count[input]++] = codec.input[input];
+		} else if (TAG_KIND(tag) == TAG_BYTES && TAG_INDEX(tag) < INPUT_REC_INPUTS) {
+			uint64_t offset, len;
+
+			if (!get_varint(&pos, &offset) || !get_varint(&pos, &len) ||
+			    len > end - pos || frame.bytes_count == FRAME_BYTES) {
+				return false;
+			}
+			frame.bytes[frame.bytes_count].input = TAG_INDEX(tag);
+			frame.bytes[frame.bytes_count].offset = offset;
+			frame.bytes[frame.bytes_count].len = len;
+			frame.bytes[frame.bytes_count].data = &replay_data[pos];
+			frame.bytes_count++;
+			pos += len;
+		} else if (tag == TAG_RESULT) {
+			if (!get_varint(&pos, &z)) {
+				return false;
+			}
+			codec.result = unzigzag(z, codec.result);
+			frame.result = codec.result;
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	/* The recording stopped inside the call */
+	return false;
+}
+
+static void replay_begin(enum input_rec_call call, uint64_t arg)
+{
+	ARG_UNUSED(arg);
+
+	if (resetting || broken || self() != driver || !enter()) {
+		return;
+	}
+
+	if (pos >= end || replay_data[pos] != (TAG_CALL | call)) {
+		memset(&frame, 0, sizeof(frame));
+		frame.live = true;
+		replay.unrecorded++;
+		return;
+	}
+
+	if (!frame_load()) {
+		LOG_ERR("Replay: %s at %u is truncated or malformed", call_names[call],
+			(uint32_t)frame.at);
+		broken = true;
+		frame.live = true;
+	}
+}
+
+static uint64_t replay_end(uint64_t result)
+{
+	if (!leave() || frame.live) {
+		return result;
+	}
+
+	for (int i = 0; i < INPUT_REC_INPUTS; i++) {
+		replay.unused += frame.count[i] - frame.used[i];
+	}
+	for (int i = 0; i < frame.bytes_count; i++) {
+		replay.unused += frame.bytes[i].used ? 0U : 1U;
+	}
+
+	if (result == frame.result) {
+		replay.matched++;
+	} else {
+		if (replay.differed < MISMATCH_LOG_MAX) {
+			LOG_WRN("Replay: %s at %u returned %llu, recorded %llu",
+				call_names[frame.call], (uint32_t)frame.at, result,
+				frame.result);
+		}
+		replay.differed++;
+	}
+
+	return result;
+}
+
+__attribute__((no_instrument_function))
+static uint64_t replay_value(enum input_rec_input input, uint64_t value)
+{
+	if (!in_call() || frame.live) {
+		return value;
+	}
+
+	if (frame.used[input] < frame.count[input]) {
+		return frame.values[input][frame.used[input]++];
+	}
+
+	/* More reads than recorded: time stands still */
+	replay.extra++;
+	return (frame.count[input] != 0U) ? frame.values[input][frame.count[input] - 1U] : value;
+}
+
+static void replay_bytes(enum input_rec_input input, size_t offset, void *data, size_t len)
+{
+	if (!in_call() || frame.live) {
+		return;
+	}
+
+	for (int i = 0; i < frame.bytes_count; i++) {
+		if (!frame.bytes[i].used && frame.bytes[i].input == input &&
+		    frame.bytes[i].offset == offset && frame.bytes[i].len == len) {
+			memcpy(data, frame.bytes[i].data, len);
+			frame.bytes[i].used = true;
+			return;
+		}
+	}
+
+	replay.extra++;
+}
+
+static void dispatch(enum input_rec_call call, uint64_t arg)
+{
+	switch (call) {
+	case INPUT_REC_CALL_VALIDATE:
+		(void)retained_validate();
+		break;
+	case INPUT_REC_CALL_UPDATE:
+		retained_update();
+		break;
+	case INPUT_REC_CALL_RESTORE:
+#ifdef CONFIG_APP_EARLY_RESTORE
+		(void)utc_time_restore();
+#endif
+		break;
+	case INPUT_REC_CALL_CALIBRATE:
+		utc_time_calibrate(arg);
+		break;
+	case INPUT_REC_CALL_GET_US:
+		(void)utc_time_get_us();
+		break;
+	case INPUT_REC_CALL_INVALIDATE:
+		utc_time_invalidate();
+		break;
+	default:
+		break;
+	}
+}
+
+static void run(void)
+{
+	while (pos < end && !broken) {
+		uint8_t tag = replay_data[pos];
+
+		if (tag == TAG_RESET) {
+			/* What a reset takes: the RAM copies and the encoder */
+			pos++;
+			memset(&codec, 0, sizeof(codec));
+			memset(&retained, 0xa5, sizeof(retained));
+			resetting = true;
+			utc_time_invalidate();
+			resetting = false;
+			replay.resets++;
+			continue;
+		}
+
+		if (TAG_KIND(tag) != TAG_CALL || TAG_INDEX(tag) >= INPUT_REC_CALLS) {
+			LOG_ERR("Replay: unexpected record 0x%02x at %u", tag, (uint32_t)pos);
+			broken = true;
+			break;
+		}
+
+		enum input_rec_call call = TAG_INDEX(tag);
+		size_t at = pos + 1U;
+		size_t before = pos;
+		uint64_t z;
+
+		if (!get_varint(&at, &z)) {
+			LOG_ERR("Replay: %s at %u is truncated", call_names[call], (uint32_t)pos);
+			broken = true;
+			break;
+		}
+
+		timing_t start = timing_counter_get();
+
+		dispatch(call, unzigzag(z, codec.arg));
+
+		timing_t stop = timing_counter_get();
+
+		if (pos == before) {
+			LOG_ERR("Replay: %s is not recorded by this build", call_names[call]);
+			broken = true;
+			break;
+		}
+		replay.calls[call]++;
+		replay.cycles[call] += timing_cycles_get(&start, &stop);
+	}
+}
+
+int input_rec_replay(void)
+{
+	struct rec_header hdr;
+	size_t region_size;
+	const uint8_t *region = retained_region_view(&region_size);
+	static uint8_t region_backup[4096];
+	struct retained_data retained_backup = retained;
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	replay_data = input_rec_stream(&replay_size);
+#else
+	replay_data = replay_file;
+	replay_size = sizeof(replay_file);
+#endif
+
+	if (replay_size < sizeof(hdr)) {
+		LOG_ERR("Replay: no stream");
+		return -EBADMSG;
+	}
+	memcpy(&hdr, replay_data, sizeof(hdr));
+	if (hdr.magic != REC_MAGIC || hdr.version != REC_VERSION ||
+	    hdr.len > replay_size - sizeof(hdr)) {
+		LOG_ERR("Replay: not a version %u stream", REC_VERSION);
+		return -EBADMSG;
+	}
+
+	__ASSERT_NO_MSG(region_size <= sizeof(region_backup));
+	memcpy(region_backup, region, region_size);
+
+	timing_init();
+	timing_start();
+	(void)zbus_obs_set_enable(&status_logger, false);
+
+	memset(&replay, 0, sizeof(replay));
+	memset(&codec, 0, sizeof(codec));
+	pos = sizeof(hdr);
+	end = sizeof(hdr) + hdr.len;
+	broken = false;
+	driver = k_current_get();
+	replaying = true;
+
+	run();
+
+	replaying = false;
+	(void)zbus_obs_set_enable(&status_logger, true);
+
+	memcpy((uint8_t *)region, region_backup, region_size);
+	retained = retained_backup;
+
+	LOG_INF("Replay: %u bytes%s, %u resets, %u skipped at recording",
+		hdr.len, (hdr.flags & REC_FLAG_FULL) ? " (recorder full)" : "",
+		replay.resets, hdr.skipped);
+	for (int i = 0; i < INPUT_REC_CALLS; i++) {
+		if (replay.calls[i] != 0U) {
+			LOG_INF("Replay: %-9s %6u calls, mean %llu ns", call_names[i],
+				replay.calls[i],
+				timing_cycles_to_ns(replay.cycles[i] / replay.calls[i]));
+		}
+	}
+	LOG_INF("Replay: results %u matched, %u differed; %u unrecorded calls, "
+		"%u extra / %u unused inputs",
+		replay.matched, replay.differed, replay.unrecorded, replay.extra,
+		replay.unused);
+
+	if (broken) {
+		LOG_ERR("Replay: INCOMPLETE at %u of %u bytes", (uint32_t)(pos - sizeof(hdr)),
+			hdr.len);
+		return -EBADMSG;
+	}
+	if (replay.differed != 0U) {
+		LOG_WRN("Replay: DIVERGED");
+		return -EIO;
+	}
+
+	LOG_INF("Replay: EXACT");
+	return 0;
+}
+
+#endif /* CONFIG_APP_INPUT_REC_REPLAY */
+
+/* While a replay runs, its hooks take every call: nothing it makes is
+ * recorded, in particular not into the stream it reads.
+ */
+void input_rec_begin(enum input_rec_call call, uint64_t arg)
+{
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+	if (replaying) {
+		replay_begin(call, arg);
+		return;
+	}
+#endif
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	record_begin(call, arg);
+#endif
+}
+
+uint64_t input_rec_end(uint64_t result)
+{
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+	if (replaying) {
+		return replay_end(result);
+	}
+#endif
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	return record_end(result);
+#else
+	return result;
+#endif
+}
+
+__attribute__((no_instrument_function))
+uint64_t input_rec_value(enum input_rec_input input, uint64_t value)
+{
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+	if (replaying) {
+		return replay_value(input, value);
+	}
+#endif
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	return record_value(input, value);
+#else
+	return value;
+#endif
+}
+
+void input_rec_bytes(enum input_rec_input input, size_t offset, void *data, size_t len)
+{
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+	if (replaying) {
+		replay_bytes(input, offset, data, len);
+		return;
+	}
+#endif
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	record_bytes(input, offset, data, len);
+#endif
+}
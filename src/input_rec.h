@@ -0,0 +1,150 @@
+/*
+ * Record / replay of timekeeping inputs - Header File
+ *
+ * CONFIG_APP_INPUT_REC_RECORD logs every call into the recorded
+ * utc_time and retained entry points, together with everything the
+ * call took from the outside: GRTC reads, the kernel uptime, the
+ * bytes read from the retained region and the RAM copy handed to
+ * retained_update(), plus the result.  Values are
+ * delta and varint coded per kind, so a GRTC read is 2-4 bytes.  The
+ * stream lives in a no-init RAM buffer that survives soft and
+ * watchdog resets; each boot appends a reset marker.  It is readable
+ * over SMP as section "rec" (smp_retained.c).
+ *
+ * CONFIG_APP_INPUT_REC_REPLAY (native_sim) builds such a stream into
+ * the image and input_rec_replay() runs it: every recorded call is
+ * made again, the inputs are served from the stream instead of the
+ * hardware, and each result is compared with the recorded one.  The
+ * inputs of a call are served per kind in order, so a change that
+ * reads the counter fewer or more times still replays (the last value
+ * repeats).  Record and replay with the same configuration: listeners
+ * and log timestamps read the GRTC inside recorded calls too.
+ * With both options the image replays what it recorded so far in the
+ * same run, which checks the recorder and the replay against each
+ * other.
+ *
+ * Only calls from thread context are recorded; a call made by another
+ * thread while one is being recorded is counted as skipped.
+ */
+
+#ifndef INPUT_REC_H
+#define INPUT_REC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum input_rec_call {
+	INPUT_REC_CALL_VALIDATE,   /* retained_validate() */
+	INPUT_REC_CALL_UPDATE,     /* retained_update() */
+	INPUT_REC_CALL_RESTORE,    /* utc_time_restore() */
+	INPUT_REC_CALL_CALIBRATE,  /* utc_time_calibrate(arg) */
+	INPUT_REC_CALL_GET_US,     /* utc_time_get_us() */
+	INPUT_REC_CALL_INVALIDATE, /* utc_time_invalidate() */
+	INPUT_REC_CALLS,
+};
+
+enum input_rec_input {
+	/* Values, input_rec_value() */
+	INPUT_REC_GRTC,
+	INPUT_REC_UPTIME,
+	/* Bytes, input_rec_bytes() */
+	INPUT_REC_REGION,          /* read from the retained region */
+	INPUT_REC_RETAINED,        /* struct retained_data in RAM */
+	INPUT_REC_INPUTS,
+};
+
+#ifdef CONFIG_APP_INPUT_REC
+
+/**
+ * @brief Enter a recorded call
+ *
+ * Nested calls are part of the outer one.
+ *
+ * @param call Entry point
+ * @param arg Its argument, 0 if none
+ */
+void input_rec_begin(enum input_rec_call call, uint64_t arg);
+
+/**
+ * @brief Leave the call entered with input_rec_begin()
+ *
+ * @param result What the call returns or changed
+ * @return @p result
+ */
+uint64_t input_rec_end(uint64_t result);
+
+/**
+ * @brief Pass an input value through the recorder
+ *
+ * @param input Kind of input
+ * @param value Live value
+ * @return @p value, or the recorded value while replaying
+ */
+uint64_t input_rec_value(enum input_rec_input input, uint64_t value);
+
+/**
+ * @brief Pass input bytes through the recorder
+ *
+ * While replaying @p data is overwritten with the recorded bytes.
+ *
+ * @param input Kind of input
+ * @param offset Where the bytes come from, e.g. the region offset
+ * @param data Bytes
+ * @param len Number of bytes
+ */
+void input_rec_bytes(enum input_rec_input input, size_t offset, void *data, size_t len);
+
+#else
+
+static inline void input_rec_begin(enum input_rec_call call, uint64_t arg) {}
+static inline uint64_t input_rec_end(uint64_t result) { return result; }
+__attribute__((no_instrument_function))
+static inline uint64_t input_rec_value(enum input_rec_input input, uint64_t value)
+{
+	return value;
+}
+static inline void input_rec_bytes(enum input_rec_input input, size_t offset,
+				   void *data, size_t len) {}
+
+#endif /* CONFIG_APP_INPUT_REC */
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+
+/**
+ * @brief Get the recorded stream, header included
+ *
+ * @param size Set to the stream size in bytes
+ * @return Start of the stream
+ */
+const uint8_t *input_rec_stream(size_t *size);
+
+/**
+ * @brief Log the stream size, the calls recorded and whether the
+ * buffer filled up
+ */
+void input_rec_print(void);
+
+#else
+
+static inline void input_rec_print(void) {}
+
+#endif /* CONFIG_APP_INPUT_REC_RECORD */
+
+#ifdef CONFIG_APP_INPUT_REC_REPLAY
+
+/**
+ * @brief Replay the built-in stream and log the comparison
+ *
+ * @return 0 if every result matched, -EIO if one differed, -EBADMSG if
+ * the stream could not be replayed to its end
+ */
+int input_rec_replay(void);
+
+#else
+
+static inline int input_rec_replay(void) { return 0; }
+
+#endif /* CONFIG_APP_INPUT_REC_REPLAY */
+
+#endif /* INPUT_REC_H */
@@ -0,0 +1,187 @@
+/*
+ * Log-linear latency histogram
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "latency_hist.h"
+#include "retained.h"
+
+BUILD_ASSERT(LATENCY_HIST_SUB_BITS < LATENCY_HIST_MAX_BITS &&
+	     LATENCY_HIST_MAX_BITS <= 32,
+	     "invalid latency histogram geometry");
+BUILD_ASSERT(sizeof(struct latency_hist) + sizeof(uint32_t) <= RETAINED_HIST_SIZE,
+	     "latency histogram does not fit its retained window");
+
+/* 32-bit atomics on the uint32_t fields: Zephyr's where atomic_t (a
+ * long) is 32 bits wide, the compiler's on 64-bit native_sim
+ */
+#if __SIZEOF_LONG__ == 4
+static inline uint32_t u32_get(const uint32_t *p)
+{
+	return (uint32_t)atomic_get((const atomic_t *)p);
+}
+
+static inline void u32_add(uint32_t *p, uint32_t value)
+{
+	(void)atomic_add((atomic_t *)p, (atomic_val_t)value);
+}
+
+static inline bool u32_cas(uint32_t *p, uint32_t old, uint32_t value)
+{
+	return atomic_cas((atomic_t *)p, (atomic_val_t)old, (atomic_val_t)value);
+}
+
+static inline void u32_clear(uint32_t *p)
+{
+	(void)atomic_clear((atomic_t *)p);
+}
+#else
+static inline uint32_t u32_get(const uint32_t *p)
+{
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static inline void u32_add(uint32_t *p, uint32_t value)
+{
+	(void)__atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline bool u32_cas(uint32_t *p, uint32_t old, uint32_t value)
+{
+	return __atomic_compare_exchange_n(p, &old, value, false, __ATOMIC_SEQ_CST,
+					   __ATOMIC_SEQ_CST);
+}
+
+static inline void u32_clear(uint32_t *p)
+{
+	__atomic_store_n(p, 0U, __ATOMIC_SEQ_CST);
+}
+#endif
+
+/* Raise *target to value if it is larger, lock-free */
+static void atomic_max_u32(uint32_t *target, uint32_t value)
+{
+	uint32_t old = u32_get(target);
+
+	while (old < value) {
+		if (u32_cas(target, old, value)) {
+			break;
+		}
+		old = u32_get(target);
+	}
+}
+
+/* Upper bound (inclusive) of the values mapped to a bucket */
+static uint32_t bucket_upper(uint32_t index)
+{
+	if (index < LATENCY_HIST_SUB_COUNT) {
+		return index;
+	}
+
+	uint32_t shift = (index >> LATENCY_HIST_SUB_BITS) - 1U;
+	uint64_t low = (uint64_t)(LATENCY_HIST_SUB_COUNT +
+				  (index & (LATENCY_HIST_SUB_COUNT - 1U))) << shift;
+
+	if (index == LATENCY_HIST_BUCKETS - 1U) {
+		return UINT32_MAX;
+	}
+
+	return (uint32_t)(low + (1ULL << shift) - 1U);
+}
+
+void latency_hist_record(struct latency_hist *hist, uint32_t value)
+{
+	u32_add(&hist->buckets[latency_hist_index(value)], 1U);
+	atomic_max_u32(&hist->max, value);
+	atomic_max_u32(&hist->min_inv, ~value);
+	u32_add(&hist->count, 1U);
+}
+
+void latency_hist_reset(struct latency_hist *hist)
+{
+	u32_clear(&hist->count);
+	u32_clear(&hist->min_inv);
+	u32_clear(&hist->max);
+	for (size_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+		u32_clear(&hist->buckets[i]);
+	}
+}
+
+void latency_hist_merge(struct latency_hist *dst, const struct latency_hist *src)
+{
+	if (latency_hist_count(src) == 0U) {
+		return;
+	}
+
+	for (size_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+		uint32_t n = u32_get(&src->buckets[i]);
+
+		if (n != 0U) {
+			u32_add(&dst->buckets[i], n);
+		}
+	}
+	atomic_max_u32(&dst->max, u32_get(&src->max));
+	atomic_max_u32(&dst->min_inv, u32_get(&src->min_inv));
+	u32_add(&dst->count, u32_get(&src->count));
+}
+
+uint32_t latency_hist_count(const struct latency_hist *hist)
+{
+	return u32_get(&hist->count);
+}
+
+uint32_t latency_hist_min(const struct latency_hist *hist)
+{
+	if (latency_hist_count(hist) == 0U) {
+		return 0;
+	}
+
+	return ~u32_get(&hist->min_inv);
+}
+
+uint32_t latency_hist_max(const struct latency_hist *hist)
+{
+	return u32_get(&hist->max);
+}
+
+uint32_t latency_hist_percentile(const struct latency_hist *hist, uint32_t per_mille)
+{
+	uint32_t count = latency_hist_count(hist);
+	uint32_t max = latency_hist_max(hist);
+
+	if (count == 0U) {
+		return 0;
+	}
+
+	/* Rank of the requested sample, 1-based and rounded up */
+	uint64_t rank = ((uint64_t)count * MIN(per_mille, 1000U) + 999U) / 1000U;
+	uint64_t seen = 0;
+
+	rank = MAX(rank, 1U);
+
+	for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+		seen += u32_get(&hist->buckets[i]);
+		if (seen >= rank) {
+			return MIN(bucket_upper(i), max);
+		}
+	}
+
+	return max;
+}
+
+int latency_hist_save(const struct latency_hist *hist, size_t offset)
+{
+	return retained_blob_write(offset, hist, sizeof(*hist));
+}
+
+int latency_hist_restore(struct latency_hist *hist, size_t offset)
+{
+	int err = retained_blob_read(offset, hist, sizeof(*hist));
+
+	if (err) {
+		memset(hist, 0, sizeof(*hist));
+	}
+
+	return err;
+}
@@ -0,0 +1,148 @@
+/*
+ * Log-linear latency histogram - Header File
+ *
+ * Fixed-size HDR-style histogram: values below 2^LATENCY_HIST_SUB_BITS
+ * get one bucket each, every higher power of two is split into
+ * 2^LATENCY_HIST_SUB_BITS linear sub-buckets, so the relative bucket
+ * width never exceeds 2^-LATENCY_HIST_SUB_BITS.  Values of
+ * 2^LATENCY_HIST_MAX_BITS and above share the top bucket (the exact
+ * maximum is still tracked).
+ *
+ * Recording is O(1) and lock-free (atomics only), so it is safe from
+ * threads and ISRs alike.  The unit of the values is up to the caller
+ * (microseconds, timing cycles, ...).  The fields are fixed-width, so
+ * a histogram saved to the retained region has the same size on 32-
+ * and 64-bit targets.
+ */
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#ifndef LATENCY_HIST_SUB_BITS
+#define LATENCY_HIST_SUB_BITS 3
+#endif
+
+#ifndef LATENCY_HIST_MAX_BITS
+#define LATENCY_HIST_MAX_BITS 28
+#endif
+
+#define LATENCY_HIST_SUB_COUNT (1U << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_BUCKETS \
+	((LATENCY_HIST_MAX_BITS - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_COUNT)
+
+/**
+ * @brief Latency histogram
+ *
+ * All-zero is the valid empty state, so instances can be static or
+ * cleared with memset().
+ */
+struct latency_hist {
+	uint32_t count;         /**< Number of recorded values */
+	uint32_t min_inv;       /**< Bitwise inverse of the minimum */
+	uint32_t max;           /**< Maximum recorded value */
+	uint32_t buckets[LATENCY_HIST_BUCKETS];
+};
+
+/**
+ * @brief Define a zero-initialized histogram
+ */
+#define LATENCY_HIST_DEFINE(name) struct latency_hist name
+
+/**
+ * @brief Bucket index of a value
+ *
+ * @param value Value to classify
+ * @return Bucket index, 0 .. LATENCY_HIST_BUCKETS - 1
+ */
+static inline uint32_t latency_hist_index(uint32_t value)
+{
+	if (value < LATENCY_HIST_SUB_COUNT) {
+		return value;
+	}
+
+	uint32_t msb = 31U - (uint32_t)__builtin_clz(value);
+
+	if (msb >= LATENCY_HIST_MAX_BITS) {
+		return LATENCY_HIST_BUCKETS - 1U;
+	}
+
+	uint32_t shift = msb - LATENCY_HIST_SUB_BITS;
+
+	return ((shift + 1U) << LATENCY_HIST_SUB_BITS) +
+	       ((value >> shift) & (LATENCY_HIST_SUB_COUNT - 1U));
+}
+
+/**
+ * @brief Record one value
+ *
+ * @param hist Histogram
+ * @param value Value to record
+ */
+void latency_hist_record(struct latency_hist *hist, uint32_t value);
+
+/**
+ * @brief Clear all recorded values
+ *
+ * @param hist Histogram
+ */
+void latency_hist_reset(struct latency_hist *hist);
+
+/**
+ * @brief Add all values recorded in @p src to @p dst
+ *
+ * @param dst Destination histogram
+ * @param src Source histogram
+ */
+void latency_hist_merge(struct latency_hist *dst, const struct latency_hist *src);
+
+/**
+ * @brief Number of recorded values
+ */
+uint32_t latency_hist_count(const struct latency_hist *hist);
+
+/**
+ * @brief Smallest recorded value (0 if empty)
+ */
+uint32_t latency_hist_min(const struct latency_hist *hist);
+
+/**
+ * @brief Largest recorded value (0 if empty)
+ */
+uint32_t latency_hist_max(const struct latency_hist *hist);
+
+/**
+ * @brief Value at a percentile
+ *
+ * Returns the upper bound of the bucket holding the requested rank,
+ * clamped to the recorded maximum, so the result never under-reports.
+ *
+ * @param hist Histogram
+ * @param per_mille Percentile in 0.1 % units (500 = median, 999 = p99.9)
+ * @return Value at the percentile (0 if empty)
+ */
+uint32_t latency_hist_percentile(const struct latency_hist *hist, uint32_t per_mille);
+
+/**
+ * @brief Save a histogram to the retained memory region
+ *
+ * @param hist Histogram
+ * @param offset Byte offset in the retained region (see retained.h)
+ * @return 0 on success, negative errno otherwise
+ */
+int latency_hist_save(const struct latency_hist *hist, size_t offset);
+
+/**
+ * @brief Restore a histogram saved with latency_hist_save()
+ *
+ * @p hist is left empty if no valid snapshot is found.
+ *
+ * @param hist Histogram
+ * @param offset Byte offset in the retained region (see retained.h)
+ * @return 0 on success, -EBADMSG if the snapshot is missing or corrupt
+ */
+int latency_hist_restore(struct latency_hist *hist, size_t offset);
+
+#endif /* LATENCY_HIST_H */
@@ -10,8 +10,30 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/reboot.h>
-#include <zephyr/drivers/timer/nrf_grtc_timer.h>
+#include "grtc.h"
 #include "retained.h"
+#include "bench.h"
+#include "profile.h"
+#include "func_trace.h"
+#include "thread_stats.h"
+#include "power_acct.h"
+#include "status.h"
+#include "sysoff.h"
+#include "boot_flags.h"
+#include "mono_time.h"
+#include "fast_clock.h"
+#include "utc_time.h"
+#include "pps.h"
+#include "utc_trigger.h"
+#include "fault_inject.h"
+#include "parse_fuzz.h"
+#include "early_init.h"
+#include "coalesce.h"
+#include "soak.h"
+#include "input_rec.h"
+#include "ota.h"
+#include "warm_cache.h"
+#include "obj_pool.h"
 #include <zephyr/drivers/watchdog.h>
 #include <zephyr/device.h>
 #include <stdbool.h>
@@ -39,6 +61,7 @@ LOG_MODULE_REGISTER(utc_time_demo, LOG_LEVEL_INF);
 #ifndef WDT_OPT
 #define WDT_OPT WDT_OPT_PAUSE_HALTED_BY_DBG
 #endif
+#ifdef WDT_TEST
 int wdt_channel_id;
 const struct device *const wdt = DEVICE_DT_GET(DT_ALIAS(watchdog0));
 
@@ -98,6 +121,26 @@ int watch_dog(void)
 	return 0;
 }
 
+#ifdef CONFIG_APP_COALESCE
+/* Fed from the coalescing scheduler instead of a sleeping loop:
+ * WDT_FEED_TRIES feeds, then the watchdog is left to expire.
+ */
+static void wdt_feeder_fn(struct coalesce_task *task)
+{
+	static int fed;
+
+	LOG_INF("Feeding watchdog...\n");
+	wdt_feed(wdt, wdt_channel_id);
+	if (++fed == WDT_FEED_TRIES) {
+		coalesce_cancel(task);
+	}
+}
+
+static COALESCE_TASK_DEFINE(wdt_feeder, wdt_feeder_fn, WDG_FEED_INTERVAL * 1000U,
+			    WDG_FEED_INTERVAL * 1000U / 2U);
+#endif
+#endif /* WDT_TEST */
+
 // Work queue for triggering software reset
 static void reboot_work_handler(struct k_work *work);
 static K_WORK_DELAYABLE_DEFINE(reboot_work, reboot_work_handler);
@@ -109,7 +152,7 @@ static void reboot_work_handler(struct k_work *work)
 	LOG_WRN("========================================");
 	
 	// Record GRTC state before reset
-	uint64_t grtc_before = z_nrf_grtc_timer_read();
+	uint64_t grtc_before = grtc_read_us();
 	
 	LOG_WRN("BEFORE RESET:");
 	LOG_WRN("  GRTC counter: %llu us (%.3f sec)", grtc_before, (double)grtc_before / 1000000.0);
@@ -120,12 +163,21 @@ static void reboot_work_handler(struct k_work *work)
 	// Update retained memory - increment boots counter
 	retained.boots++;
 	retained_update();
+	thread_stats_sample();
 	LOG_WRN(">>> Saved retained data to RAM:");
 	LOG_WRN("    boots=%u, off_count=%u, uptime_sum=%llu", 
 	        retained.boots, retained.off_count, retained.uptime_sum);
 	
 	k_msleep(100); // Allow time for log output
 	
+	profile_dump();
+	status_publish_reset(RESET_EVENT_REQUESTED, true);
+
+	// Stamp the GRTC so the next boot can account the reset gap
+	power_acct_enter_off();
+	boot_flags_set(BOOT_FLAG_RESET_REQUESTED);
+	mono_time_seal();
+
 	// Execute software reset
 	sys_reboot(SYS_REBOOT_COLD);	
 }
@@ -135,9 +187,11 @@ int main(void)
 	LOG_INF("GRTC Retention Test Starting...");
 	LOG_INF("========================================");
 	
-	// Initialize retained memory
-	bool retained_ok = retained_validate();
+	// Initialize retained memory (already validated before the kernel
+	// with CONFIG_APP_EARLY_RESTORE)
+	bool retained_ok = early_init_retained_valid();
 	LOG_INF("Retained RAM: %s", retained_ok ? "VALID" : "INVALID (first boot)");
+	status_publish_reset(RESET_EVENT_BOOT, retained_ok);
 	if (retained_ok) {
 		LOG_INF("=== Retained Data ===");
 		LOG_INF("  boots:         %u", retained.boots);
@@ -148,13 +202,53 @@ int main(void)
 		        (double)retained.uptime_sum * 1000.0 / CONFIG_SYS_CLOCK_TICKS_PER_SEC / 1000.0);
 		LOG_INF("  crc:           0x%08x", retained.crc);
 	}
+	early_init_report();
+	ota_boot_check();
+	warm_cache_init();
+	obj_pool_init();
+	mono_time_init();
+	fast_clock_init();
+	uint8_t boot_flags = boot_flags_take();
+
+	if (IS_ENABLED(CONFIG_APP_BOOT_FLAGS)) {
+		LOG_INF("Boot flags: 0x%02x (reset %s)", boot_flags,
+		        (boot_flags & BOOT_FLAG_RESET_REQUESTED) ? "requested" : "not requested");
+	}
+	power_acct_init();
+	sysoff_report();
+	power_acct_print();
+	ota_print();
+	warm_cache_demo_run();
+	warm_cache_print();
+	obj_pool_demo_run();
+	obj_pool_print();
+	thread_stats_init();
+
+	if (CONFIG_APP_UTC_BOOT_TIME[0] != '\0') {
+		(void)utc_time_calibrate_str(CONFIG_APP_UTC_BOOT_TIME);
+	}
+	(void)pps_init();
+	(void)utc_trigger_demo_init();
+	coalesce_demo_start();
 	
 	// Check GRTC current state (post-reset verification)
-	uint64_t grtc_raw = z_nrf_grtc_timer_read();
+	uint64_t grtc_raw = grtc_read_us();
 	
 	LOG_INF("GRTC raw counter: %llu us (%.3f seconds)", grtc_raw, (double)grtc_raw / 1000000.0);
 	LOG_WRN("Current boot count: %u", retained.boots);
 
+#ifdef CONFIG_APP_BENCH
+	bench_run();
+#endif
+	fault_inject_run();
+	(void)parse_fuzz_run();
+	(void)soak_run();
+	(void)input_rec_replay();
+	input_rec_print();
+
+	/* Boot path trace: everything up to and including start-up above */
+	func_trace_dump();
+
 #ifndef WDT_TEST	
 	// Check if recovering from software reset
 	if (grtc_raw > 1000000ULL) {
@@ -166,6 +260,7 @@ int main(void)
 		
 		// Increment off_count (reset counter)
 		retained.off_count++;
+		retained_update();
 	} else {
 		LOG_INF(">>> GRTC appears to be freshly started (first boot or hard reset)");
 		LOG_INF(">>> Counter < 1 second indicates cold boot");
@@ -197,46 +292,42 @@ int main(void)
 		LOG_INF("========================================");
 		LOG_INF("The GRTC counter has persisted through %u software resets", MAX_REBOOTS);
 		LOG_INF("Current GRTC value: %llu us (%.3f seconds)", 
-		        z_nrf_grtc_timer_read(), 
-		        (double)z_nrf_grtc_timer_read() / 1000000.0);
-	}
-#else
-	watch_dog();
-#endif		
-#ifndef WDT_TEST
-	// Keep program running, continuously display GRTC counter
-	while (1) {
+		        grtc_read_us(), 
+		        (double)grtc_read_us() / 1000000.0);
+		profile_dump();
 
-	k_sleep(K_SECONDS(1));				
+#ifdef CONFIG_APP_SYSOFF
+		if (sysoff_cycles() < CONFIG_APP_SYSOFF_CYCLES) {
+			int err;
 
-	/* Waiting for the SoC reset. */
-	LOG_INF("Waiting for reset...\n");		
-		k_sleep(K_SECONDS(10));
-		uint64_t grtc_current = z_nrf_grtc_timer_read();
-		
-		// Update retained memory to accumulate uptime
-		retained_update();
-		
-		LOG_INF("=== Status ===");
-		LOG_INF("GRTC: %llu us (%.3f sec)", 
-		        grtc_current,
-		        (double)grtc_current / 1000000.0);
-		LOG_INF("Retained: boots=%u, off_count=%u, uptime_sum=%llu ticks (%.3f sec)",
-		        retained.boots,
-		        retained.off_count,
-		        retained.uptime_sum,
-		        (double)retained.uptime_sum * 1000.0 / CONFIG_SYS_CLOCK_TICKS_PER_SEC / 1000.0);
+			LOG_INF("\n=== SYSTEM OFF TEST: cycle %u / %u ===",
+			        sysoff_cycles() + 1, CONFIG_APP_SYSOFF_CYCLES);
+			k_sleep(K_SECONDS(1));
+			err = sysoff_enter(CONFIG_APP_SYSOFF_SLEEP_MS);
+			LOG_ERR("System OFF test aborted (%d)", err);
+		}
+#endif
 	}
 #else
+	watch_dog();
+#endif		
+	/* Nothing polls from here on: clock, retained and reset changes
+	 * are published on zbus by the code that makes them (status.h).
+	 */
+#ifdef WDT_TEST
 	/* Feeding watchdog. */
 
 	LOG_INF("Feeding watchdog %d times\n", WDT_FEED_TRIES);
 
+#ifdef CONFIG_APP_COALESCE
+	coalesce_schedule(&wdt_feeder, grtc_read_us());
+#else
 	for (int i = 0; i < WDT_FEED_TRIES; ++i) {
 		LOG_INF("Feeding watchdog...\n");
 		wdt_feed(wdt, wdt_channel_id);
 		k_sleep(K_MSEC(WDG_FEED_INTERVAL));
 	}
+#endif
 #endif	
 	return 0;
 }
@@ -0,0 +1,157 @@
+/*
+ * Cross-reset monotonic clock
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "mono_time.h"
+#include "retained.h"
+#include "coalesce.h"
+
+LOG_MODULE_REGISTER(mono_time, LOG_LEVEL_INF);
+
+#define LEASE_US ((uint64_t)CONFIG_APP_MONO_TIME_LEASE_MS * 1000U)
+
+/* Two copies, written in turn with an increasing sequence number: a
+ * write torn by a reset leaves the other one
+ */
+struct mono_time_state {
+	uint32_t seq;
+	uint64_t base_us;
+	/* No value handed out so far is larger than this */
+	uint64_t horizon_us;
+};
+
+#define STATE_STRIDE ROUND_UP(sizeof(struct mono_time_state) + sizeof(uint32_t), 4)
+#define STATE_OFFSET(copy) (RETAINED_MONO_TIME_OFFSET + (copy) * STATE_STRIDE)
+
+BUILD_ASSERT(2 * STATE_STRIDE <= RETAINED_MONO_TIME_SIZE,
+	     "mono_time state does not fit its retained window");
+
+uint64_t mono_time_base_us;
+
+static bool initialized;
+
+/* Stores come from retained_update() and from the lease work */
+static struct k_spinlock lock;
+static uint32_t seq;
+
+#ifdef CONFIG_APP_COALESCE
+/* Renewed every half lease, at most a quarter lease late */
+static void lease_fn(struct coalesce_task *task);
+static COALESCE_TASK_DEFINE(mono_lease, lease_fn, (uint32_t)(LEASE_US / 2U),
+			    (uint32_t)(LEASE_US / 4U));
+#else
+static void lease_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(lease_work, lease_work_handler);
+#endif
+
+/* Over the older copy; horizon_us is relative to now */
+static void store(uint64_t lease_us)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct mono_time_state state = {
+		.seq = ++seq,
+		.base_us = mono_time_base_us,
+		.horizon_us = mono_time_get_us() + lease_us,
+	};
+
+	(void)retained_blob_write(STATE_OFFSET(seq & 1U), &state, sizeof(state));
+	k_spin_unlock(&lock, key);
+}
+
+/* Newest valid copy, false if there is none */
+static bool load(struct mono_time_state *state)
+{
+	struct mono_time_state copy;
+	bool found = false;
+
+	for (int c = 0; c < 2; c++) {
+		if (retained_blob_read(STATE_OFFSET(c), &copy, sizeof(copy)) == 0 &&
+		    (!found || (int32_t)(copy.seq - state->seq) > 0)) {
+			*state = copy;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+#ifdef CONFIG_APP_COALESCE
+static void lease_fn(struct coalesce_task *task)
+{
+	ARG_UNUSED(task);
+	mono_time_update();
+}
+#else
+static void lease_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	mono_time_update();
+	k_work_schedule(&lease_work, K_MSEC(CONFIG_APP_MONO_TIME_LEASE_MS / 2));
+}
+#endif
+
+void mono_time_init(void)
+{
+	struct mono_time_state state;
+	uint64_t now = grtc_read_us();
+
+	if (load(&state)) {
+		seq = state.seq;
+		mono_time_base_us = state.base_us;
+
+		/* Values up to the horizon may have been handed out before
+		 * the reset; if the GRTC is not past it, it restarted or the
+		 * reset came without mono_time_seal().
+		 */
+		if (now + mono_time_base_us < state.horizon_us) {
+			LOG_WRN("Unannounced reset or GRTC restart, advancing %llu us",
+				state.horizon_us - (now + mono_time_base_us));
+			mono_time_base_us = state.horizon_us - now;
+		}
+	} else {
+		/* Lost (first boot, or the region was cleared): start no
+		 * earlier than the time the retained data has seen pass
+		 */
+		mono_time_base_us = k_ticks_to_us_floor64(retained.uptime_sum) + retained.off_us;
+		LOG_WRN("No monotonic clock state, base from the retained uptime: %llu us",
+			mono_time_base_us);
+	}
+
+	initialized = true;
+	LOG_INF("Monotonic clock: %llu us (base %llu us)",
+		mono_time_get_us(), mono_time_base_us);
+
+#ifdef CONFIG_APP_COALESCE
+	mono_time_update();
+	coalesce_schedule_in(&mono_lease, mono_lease.period_us);
+#else
+	lease_work_handler(NULL);
+#endif
+}
+
+void mono_time_update(void)
+{
+	/* retained_update() may run before mono_time_init() */
+	if (!initialized) {
+		return;
+	}
+
+	store(LEASE_US);
+}
+
+void mono_time_seal(void)
+{
+	if (!initialized) {
+		return;
+	}
+
+#ifdef CONFIG_APP_COALESCE
+	coalesce_cancel(&mono_lease);
+#else
+	k_work_cancel_delayable(&lease_work);
+#endif
+	store(0);
+}
@@ -0,0 +1,81 @@
+/*
+ * Cross-reset monotonic clock - Header File
+ *
+ * The GRTC keeps counting through soft resets and System OFF but
+ * restarts from zero after a watchdog or pin reset.  mono_time adds a
+ * retained, CRC-protected base to the GRTC so that timestamps never go
+ * backwards across any kind of reset.
+ *
+ * The base only changes at boot.  While running, the clock hands out
+ * values below a lease horizon kept in the retained region and renewed
+ * every half lease; after a GRTC restart (or any reset that was not
+ * announced with mono_time_seal()) the clock resumes at the horizon.
+ * This relies on the renewal running at least once per lease, which a
+ * watchdog fed from a thread guarantees as long as the lease is longer
+ * than the watchdog window.
+ *
+ * The state is kept in two copies written in turn, so a reset in the
+ * middle of a write leaves the previous one.  With neither copy valid
+ * the base restarts from the uptime and off time in struct
+ * retained_data.
+ */
+
+#ifndef MONO_TIME_H
+#define MONO_TIME_H
+
+#include <stdint.h>
+#include "grtc.h"
+
+#ifdef CONFIG_APP_MONO_TIME
+
+/* Offset from the GRTC to the monotonic clock, set by mono_time_init() */
+extern uint64_t mono_time_base_us;
+
+/**
+ * @brief Read the cross-reset monotonic clock
+ *
+ * Costs one add on top of grtc_read_us().  Callable from any context.
+ *
+ * @return Microseconds, never smaller than a value returned before any
+ * earlier reset
+ */
+__attribute__((no_instrument_function))
+static inline uint64_t mono_time_get_us(void)
+{
+	return grtc_read_us() + mono_time_base_us;
+}
+
+/**
+ * @brief Restore the base from the retained region
+ *
+ * Call once after retained_validate(), before the first
+ * mono_time_get_us().  Starts the lease renewal.
+ */
+void mono_time_init(void);
+
+/**
+ * @brief Renew the lease and persist the state
+ *
+ * Called by retained_update() and by the lease renewal work.
+ */
+void mono_time_update(void);
+
+/**
+ * @brief Announce an orderly reset or System OFF
+ *
+ * Shrinks the lease to the current time so the next boot continues
+ * without a jump when the GRTC kept counting.  Call right before
+ * sys_reboot() or sys_poweroff().
+ */
+void mono_time_seal(void);
+
+#else
+
+static inline uint64_t mono_time_get_us(void) { return grtc_read_us(); }
+static inline void mono_time_init(void) {}
+static inline void mono_time_update(void) {}
+static inline void mono_time_seal(void) {}
+
+#endif /* CONFIG_APP_MONO_TIME */
+
+#endif /* MONO_TIME_H */
@@ -0,0 +1,460 @@
+/*
+ * Persistent object pool
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include "obj_pool.h"
+#include "grtc.h"
+#include "retained.h"
+
+LOG_MODULE_REGISTER(obj_pool, LOG_LEVEL_INF);
+
+struct block {
+	uint16_t type;           /* 0: free */
+	uint16_t len;
+	uint16_t gen;            /* bumped on every allocation, never 0 */
+	uint16_t reserved;
+	uint8_t data[OBJ_POOL_PAYLOAD_SIZE];
+};
+
+#define BLOCK_STRIDE ROUND_UP(sizeof(struct block) + sizeof(uint32_t), 4)
+
+/* Each block also takes its generation in both copies of the table;
+ * a copy adds its sequence number, CRC and up to 2 bytes of padding.
+ */
+#define POOL_BLOCKS ((RETAINED_POOL_SIZE - 2 * 10) / (BLOCK_STRIDE + 2 * sizeof(uint16_t)))
+
+/* Generation of every block, written before the block on allocation
+ * so that a block torn by a reset does not take its generation with
+ * it.  Two copies, written in turn: a torn table write leaves the
+ * other, which is consistent with the blocks.
+ */
+struct gen_table {
+	uint32_t seq;
+	uint16_t gens[POOL_BLOCKS];
+};
+
+#define TABLE_STRIDE ROUND_UP(sizeof(struct gen_table) + sizeof(uint32_t), 4)
+#define TABLE_OFFSET(copy) (RETAINED_POOL_OFFSET + (copy) * TABLE_STRIDE)
+#define BLOCK_OFFSET(i) (RETAINED_POOL_OFFSET + 2 * TABLE_STRIDE + (i) * BLOCK_STRIDE)
+
+BUILD_ASSERT(POOL_BLOCKS >= 1 && POOL_BLOCKS <= UINT16_MAX,
+	     "object pool window does not hold a usable number of blocks");
+BUILD_ASSERT(2 * TABLE_STRIDE + POOL_BLOCKS * BLOCK_STRIDE <= RETAINED_POOL_SIZE,
+	     "object pool exceeds its retained window");
+
+/* Handle: generation in the upper half, block index in the lower */
+#define HANDLE(i, gen) (((uint32_t)(gen) << 16) | (i))
+#define HANDLE_INDEX(h) ((h) & 0xffffU)
+#define HANDLE_GEN(h) ((uint16_t)((h) >> 16))
+
+static K_MUTEX_DEFINE(pool_lock);
+
+/* Shadow of the block types and of the generation table, rebuilt by
+ * the boot scan
+ */
+static uint16_t types[POOL_BLOCKS];
+static struct gen_table table;
+
+/* Free blocks, lowest index on top */
+static uint16_t free_stack[POOL_BLOCKS];
+static uint16_t free_top;
+
+/* What the boot scan found */
+static uint16_t scan_live;
+static uint16_t scan_invalid;
+static uint32_t scan_us;
+
+static int block_write(uint16_t i, uint16_t type, uint16_t gen, const void *data, size_t len)
+{
+	struct block b;
+
+	memset(&b, 0, sizeof(b));
+	b.type = type;
+	b.len = len;
+	b.gen = gen;
+	if (len != 0U) {
+		memcpy(b.data, data, len);
+	}
+
+	return retained_blob_write(BLOCK_OFFSET(i), &b, sizeof(b));
+}
+
+/* Newest valid copy of the generation table, false if there is none */
+static bool table_load(void)
+{
+	struct gen_table copy;
+	bool found = false;
+
+	for (int c = 0; c < 2; c++) {
+		if (retained_blob_read(TABLE_OFFSET(c), &copy, sizeof(copy)) == 0 &&
+		    (!found || (int32_t)(copy.seq - table.seq) > 0)) {
+			table = copy;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/* Over the older copy, so that the newer one survives a torn write */
+static int table_store(void)
+{
+	table.seq++;
+	return retained_blob_write(TABLE_OFFSET(table.seq & 1U), &table, sizeof(table));
+}
+
+static uint16_t next_gen(uint16_t gen)
+{
+	return (gen == UINT16_MAX) ? 1U : gen + 1U;
+}
+
+/* The block index if the handle refers to a live object, else -1 */
+static int lookup(obj_pool_handle_t handle)
+{
+	uint32_t i = HANDLE_INDEX(handle);
+
+	if (i >= POOL_BLOCKS || types[i] == 0U || table.gens[i] != HANDLE_GEN(handle)) {
+		return -1;
+	}
+
+	return (int)i;
+}
+
+void obj_pool_init(void)
+{
+	uint64_t start = grtc_read_us();
+	struct block b;
+	bool have_table;
+
+	free_top = 0;
+	scan_live = 0;
+	scan_invalid = 0;
+
+	memset(&table, 0, sizeof(table));
+	have_table = table_load();
+
+	/* Downwards, so that allocation pops the lowest index first */
+	for (int i = POOL_BLOCKS - 1; i >= 0; i--) {
+		bool valid = (retained_blob_read(BLOCK_OFFSET(i), &b, sizeof(b)) == 0);
+
+		/* Without a table (first use) the blocks tell the generation */
+		if (!have_table) {
+			table.gens[i] = valid ? b.gen : 0U;
+		}
+
+		if (valid && b.type != 0U && b.gen != 0U && b.gen == table.gens[i] &&
+		    b.len <= OBJ_POOL_PAYLOAD_SIZE) {
+			types[i] = b.type;
+			scan_live++;
+			continue;
+		}
+
+		/* A free or torn block keeps the generation of its last
+		 * object, so handles to that object stay stale across the
+		 * reset.
+		 */
+		types[i] = 0;
+		if (!valid) {
+			scan_invalid++;
+		}
+		free_stack[free_top++] = i;
+	}
+
+	scan_us = (uint32_t)(grtc_read_us() - start);
+}
+
+int obj_pool_alloc(uint16_t type, const void *data, size_t len, obj_pool_handle_t *handle)
+{
+	uint16_t i;
+	uint16_t gen;
+	int err;
+
+	if (type == 0U || len > OBJ_POOL_PAYLOAD_SIZE) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	if (free_top == 0U) {
+		k_mutex_unlock(&pool_lock);
+		return -ENOMEM;
+	}
+
+	i = free_stack[free_top - 1U];
+	gen = next_gen(table.gens[i]);
+
+	/* The generation first: a reset before the block is complete
+	 * must not hand it out again
+	 */
+	table.gens[i] = gen;
+	err = table_store();
+	if (err == 0) {
+		err = block_write(i, type, gen, data, len);
+	}
+	if (err == 0) {
+		free_top--;
+		types[i] = type;
+		*handle = HANDLE(i, gen);
+	}
+
+	k_mutex_unlock(&pool_lock);
+	return err;
+}
+
+int obj_pool_read(obj_pool_handle_t handle, void *data, size_t size)
+{
+	struct block b;
+	int i;
+	int ret;
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	i = lookup(handle);
+	if (i < 0) {
+		ret = -ESTALE;
+	} else if (retained_blob_read(BLOCK_OFFSET(i), &b, sizeof(b)) != 0 ||
+		   b.gen != table.gens[i] || b.len > OBJ_POOL_PAYLOAD_SIZE) {
+		ret = -EBADMSG;
+	} else if (b.len > size) {
+		ret = -ENOSPC;
+	} else {
+		memcpy(data, b.data, b.len);
+		ret = b.len;
+	}
+
+	k_mutex_unlock(&pool_lock);
+	return ret;
+}
+
+int obj_pool_write(obj_pool_handle_t handle, const void *data, size_t len)
+{
+	int i;
+	int err;
+
+	if (len > OBJ_POOL_PAYLOAD_SIZE) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	i = lookup(handle);
+	err = (i < 0) ? -ESTALE : block_write(i, types[i], table.gens[i], data, len);
+
+	k_mutex_unlock(&pool_lock);
+	return err;
+}
+
+int obj_pool_free(obj_pool_handle_t handle)
+{
+	int i;
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	i = lookup(handle);
+	if (i < 0) {
+		k_mutex_unlock(&pool_lock);
+		return -ESTALE;
+	}
+
+	(void)block_write(i, 0, table.gens[i], NULL, 0);
+	types[i] = 0;
+	free_stack[free_top++] = i;
+
+	k_mutex_unlock(&pool_lock);
+	return 0;
+}
+
+void obj_pool_foreach(uint16_t type, obj_pool_visit_t visit, void *user_data)
+{
+	struct block b;
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	for (uint16_t i = 0; i < POOL_BLOCKS; i++) {
+		if (types[i] == 0U || (type != 0U && types[i] != type)) {
+			continue;
+		}
+		if (retained_blob_read(BLOCK_OFFSET(i), &b, sizeof(b)) != 0 ||
+		    b.gen != table.gens[i] || b.len > OBJ_POOL_PAYLOAD_SIZE) {
+			continue;
+		}
+		if (!visit(HANDLE(i, b.gen), b.type, b.data, b.len, user_data)) {
+			break;
+		}
+	}
+
+	k_mutex_unlock(&pool_lock);
+}
+
+void obj_pool_print(void)
+{
+	LOG_INF("Object pool: %u of %u blocks in use, %u B payload each", POOL_BLOCKS - free_top,
+		POOL_BLOCKS, OBJ_POOL_PAYLOAD_SIZE);
+	LOG_INF("Object pool: boot scan kept %u objects, %u invalid blocks, %u us",
+		scan_live, scan_invalid, scan_us);
+}
+
+#ifdef CONFIG_APP_OBJ_POOL_DEMO
+/* Records waiting for an upload that never comes in time: one is
+ * queued per boot and the oldest is retired once DEMO_BACKLOG wait.
+ */
+#define DEMO_TYPE_UPLOAD 1U
+#define DEMO_TYPE_CHECK  2U
+#define DEMO_BACKLOG     4U
+
+struct check_scan {
+	uint32_t count;
+	obj_pool_handle_t handle;
+};
+
+static bool check_visit(obj_pool_handle_t handle, uint16_t type, const void *data, size_t len,
+			void *user_data)
+{
+	struct check_scan *scan = user_data;
+
+	scan->count++;
+	scan->handle = handle;
+
+	return true;
+}
+
+/* Alloc, free, reuse of the block under a new handle, stale handles,
+ * the boot scan and an allocation torn by a reset.  The results of
+ * this boot's scan are put back afterwards.  Returns the number of
+ * failures.
+ */
+static uint32_t check(void)
+{
+	const uint32_t value = 0xc0ffee00U;
+	uint16_t live = scan_live;
+	uint16_t invalid = scan_invalid;
+	uint32_t us = scan_us;
+	struct check_scan scan = { 0 };
+	obj_pool_handle_t a, b, c;
+	uint32_t out = 0;
+	uint32_t failed = 0;
+	uint16_t i;
+
+	if (obj_pool_alloc(DEMO_TYPE_CHECK, &value, sizeof(value), &a) != 0) {
+		return 1;
+	}
+	failed += (obj_pool_read(a, &out, sizeof(out)) == sizeof(value) && out == value) ?
+		  0U : 1U;
+	failed += (obj_pool_free(a) == 0) ? 0U : 1U;
+	failed += (obj_pool_read(a, &out, sizeof(out)) == -ESTALE) ? 0U : 1U;
+	failed += (obj_pool_write(a, &value, sizeof(value)) == -ESTALE) ? 0U : 1U;
+	failed += (obj_pool_free(a) == -ESTALE) ? 0U : 1U;
+
+	/* The freed block comes back first, under a new handle */
+	if (obj_pool_alloc(DEMO_TYPE_CHECK, &value, sizeof(value), &b) != 0) {
+		return failed + 1U;
+	}
+	i = HANDLE_INDEX(b);
+	failed += (i == HANDLE_INDEX(a) && b != a) ? 0U : 1U;
+	failed += (obj_pool_read(a, &out, sizeof(out)) == -ESTALE) ? 0U : 1U;
+
+	/* The boot scan finds b again; a stays stale */
+	obj_pool_init();
+	obj_pool_foreach(DEMO_TYPE_CHECK, check_visit, &scan);
+	failed += (scan.count == 1U && scan.handle == b) ? 0U : 1U;
+	failed += (obj_pool_read(a, &out, sizeof(out)) == -ESTALE) ? 0U : 1U;
+
+	/* A reset in the middle of the block's next allocation: the
+	 * generation is stored, the block is left without a valid CRC
+	 */
+	failed += (obj_pool_free(b) == 0) ? 0U : 1U;
+	k_mutex_lock(&pool_lock, K_FOREVER);
+	table.gens[i] = next_gen(table.gens[i]);
+	(void)table_store();
+	(void)retained_blob_write(BLOCK_OFFSET(i), &value, sizeof(value));
+	k_mutex_unlock(&pool_lock);
+
+	obj_pool_init();
+	if (obj_pool_alloc(DEMO_TYPE_CHECK, &value, sizeof(value), &c) != 0) {
+		failed++;
+	} else {
+		failed += (HANDLE_INDEX(c) == i && c != a && c != b) ? 0U : 1U;
+		failed += (obj_pool_read(b, &out, sizeof(out)) == -ESTALE) ? 0U : 1U;
+		failed += (obj_pool_free(c) == 0) ? 0U : 1U;
+	}
+
+	scan_live = live;
+	scan_invalid = invalid;
+	scan_us = us;
+
+	return failed;
+}
+
+struct upload_record {
+	uint32_t boots;
+	uint32_t samples[8];
+};
+
+struct upload_scan {
+	uint32_t count;
+	uint32_t oldest_boots;
+	obj_pool_handle_t oldest;
+};
+
+static bool demo_visit(obj_pool_handle_t handle, uint16_t type, const void *data, size_t len,
+		       void *user_data)
+{
+	struct upload_scan *scan = user_data;
+	struct upload_record rec = { 0 };
+
+	memcpy(&rec, data, MIN(len, sizeof(rec)));
+	LOG_INF("  pending upload from boot %u, %u bytes (handle %08x)", rec.boots, len, handle);
+
+	scan->count++;
+	if (rec.boots < scan->oldest_boots) {
+		scan->oldest_boots = rec.boots;
+		scan->oldest = handle;
+	}
+
+	return true;
+}
+
+void obj_pool_demo_run(void)
+{
+	struct upload_scan scan = {
+		.oldest_boots = UINT32_MAX,
+		.oldest = OBJ_POOL_HANDLE_NONE,
+	};
+	struct upload_record rec = {
+		.boots = retained.boots,
+	};
+	/* Records of different lengths */
+	size_t n = retained.boots % (ARRAY_SIZE(rec.samples) + 1U);
+	obj_pool_handle_t handle;
+	uint32_t failed = check();
+	int err;
+
+	if (failed != 0U) {
+		LOG_ERR("Object pool check: FAIL (%u)", failed);
+	} else {
+		LOG_INF("Object pool check: PASS");
+	}
+
+	obj_pool_foreach(DEMO_TYPE_UPLOAD, demo_visit, &scan);
+	LOG_INF("Object pool demo: %u pending uploads survived", scan.count);
+
+	if (scan.count >= DEMO_BACKLOG && obj_pool_free(scan.oldest) == 0) {
+		LOG_INF("Object pool demo: uploaded the record from boot %u", scan.oldest_boots);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		rec.samples[i] = (uint32_t)grtc_read_us();
+	}
+
+	err = obj_pool_alloc(DEMO_TYPE_UPLOAD, &rec, offsetof(struct upload_record, samples) +
+			     n * sizeof(rec.samples[0]), &handle);
+	if (err) {
+		LOG_ERR("Object pool demo: queueing failed (%d)", err);
+		return;
+	}
+	LOG_INF("Object pool demo: queued the record of boot %u (handle %08x)", rec.boots, handle);
+}
+#endif /* CONFIG_APP_OBJ_POOL_DEMO */
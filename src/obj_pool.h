@@ -0,0 +1,132 @@
+/*
+ * Persistent object pool - Header File
+ *
+ * A slab of equal blocks in the retained region (window
+ * RETAINED_POOL_OFFSET) for variable-size state that must survive a
+ * reset: queue entries, pending-upload records and the like, each up
+ * to OBJ_POOL_PAYLOAD_SIZE bytes.  Objects are reached through handles
+ * (block index + generation), which stay valid across resets and can
+ * be stored inside other objects; a handle to a freed and reused block
+ * is recognised as stale.
+ *
+ * Every block is one CRC-protected blob carrying the object's type,
+ * length and generation.  obj_pool_init() makes a single pass over the
+ * blocks at boot: a valid block with a type is a surviving object,
+ * anything else goes on the free list.  Allocation and free pop and
+ * push that list, O(1) besides writing the block.  Allocation first
+ * stores the new generation in a table of all blocks (two copies,
+ * written in turn), so that a block torn by a reset keeps its
+ * generation and handles to its earlier objects stay stale.
+ *
+ * A reset in the middle of writing a block loses that object.  To
+ * replace an object atomically, allocate the new one before freeing
+ * the old one.
+ */
+
+#ifndef OBJ_POOL_H
+#define OBJ_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define OBJ_POOL_PAYLOAD_SIZE CONFIG_APP_OBJ_POOL_PAYLOAD_SIZE
+
+typedef uint32_t obj_pool_handle_t;
+
+/* Never returned for an object */
+#define OBJ_POOL_HANDLE_NONE 0U
+
+/**
+ * @brief Visit an object, see obj_pool_foreach()
+ *
+ * @return false to stop
+ */
+typedef bool (*obj_pool_visit_t)(obj_pool_handle_t handle, uint16_t type,
+				 const void *data, size_t len, void *user_data);
+
+#ifdef CONFIG_APP_OBJ_POOL
+
+/**
+ * @brief Scan the pool: keep the valid objects, free the rest
+ *
+ * Call once at boot before any other call.
+ */
+void obj_pool_init(void);
+
+/**
+ * @brief Store a new object
+ *
+ * @param type User tag, not 0
+ * @param data Contents
+ * @param len Size of the contents, at most OBJ_POOL_PAYLOAD_SIZE
+ * @param handle Set to the object's handle
+ * @return 0 on success, -ENOMEM if the pool is full, -EINVAL for a bad
+ * type or size
+ */
+int obj_pool_alloc(uint16_t type, const void *data, size_t len, obj_pool_handle_t *handle);
+
+/**
+ * @brief Read an object
+ *
+ * @param handle Object
+ * @param data Filled with the contents
+ * @param size Size of @p data
+ * @return Size of the object, -ESTALE if the handle does not refer to
+ * a live object, -ENOSPC if it does not fit @p data, -EBADMSG if the
+ * block failed its CRC
+ */
+int obj_pool_read(obj_pool_handle_t handle, void *data, size_t size);
+
+/**
+ * @brief Replace the contents of an object in place
+ *
+ * @return 0 on success, -ESTALE or -EINVAL as above
+ */
+int obj_pool_write(obj_pool_handle_t handle, const void *data, size_t len);
+
+/**
+ * @brief Free an object
+ *
+ * @return 0 on success, -ESTALE if the handle does not refer to a live
+ * object
+ */
+int obj_pool_free(obj_pool_handle_t handle);
+
+/**
+ * @brief Visit the live objects in block order
+ *
+ * @param type Only objects of this type, 0 for all
+ * @param visit Called for each object; must not allocate or free
+ * @param user_data Passed to @p visit
+ */
+void obj_pool_foreach(uint16_t type, obj_pool_visit_t visit, void *user_data);
+
+/**
+ * @brief Log the blocks in use and what the boot scan found
+ */
+void obj_pool_print(void);
+
+#else
+
+static inline void obj_pool_init(void) {}
+static inline void obj_pool_print(void) {}
+
+#endif /* CONFIG_APP_OBJ_POOL */
+
+#ifdef CONFIG_APP_OBJ_POOL_DEMO
+
+/**
+ * @brief Check alloc, free, stale handles and the boot scan on a
+ * scratch object, then list the pending records that survived, retire
+ * the oldest and queue one for this boot
+ */
+void obj_pool_demo_run(void);
+
+#else
+
+static inline void obj_pool_demo_run(void) {}
+
+#endif /* CONFIG_APP_OBJ_POOL_DEMO */
+
+#endif /* OBJ_POOL_H */
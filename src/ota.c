@@ -0,0 +1,238 @@
+/*
+ * Firmware update downtime
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/dfu/mcuboot.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/reboot.h>
+#include <zephyr/zbus/zbus.h>
+#ifdef CONFIG_MCUMGR_GRP_OS_RESET_HOOK
+#include <zephyr/mgmt/mcumgr/mgmt/callbacks.h>
+#endif
+#include <string.h>
+#include "ota.h"
+#include "boot_flags.h"
+#include "grtc.h"
+#include "mono_time.h"
+#include "power_acct.h"
+#include "retained.h"
+#include "session_hist.h"
+#include "status.h"
+#include "utc_time.h"
+
+LOG_MODULE_REGISTER(ota, LOG_LEVEL_INF);
+
+#define SLOT0_ID FIXED_PARTITION_ID(slot0_partition)
+#define SLOT1_ID FIXED_PARTITION_ID(slot1_partition)
+
+/* Stamped just before the upgrade reboot */
+struct ota_pending {
+	uint64_t grtc_us;        /* 0: no update pending */
+	uint64_t utc_us;         /* 0: clock was not calibrated */
+	uint32_t from_version;
+	uint32_t to_version;
+};
+
+BUILD_ASSERT(sizeof(struct ota_pending) + sizeof(uint32_t) <= RETAINED_OTA_SIZE,
+	     "OTA stamp does not fit its retained window");
+
+/* Downtime left to resolve from UTC: the stamp and this boot's check */
+static uint64_t resolve_utc_us;
+static uint64_t check_grtc_us;
+
+static uint32_t slot_version(uint8_t area_id)
+{
+	struct mcuboot_img_header header;
+
+	if (boot_read_bank_header(area_id, &header, sizeof(header)) != 0) {
+		return 0;
+	}
+
+	return SESSION_VERSION(header.h.v1.sem_ver.major, header.h.v1.sem_ver.minor,
+			       header.h.v1.sem_ver.revision);
+}
+
+static void stamp(void)
+{
+	struct ota_pending pending = {
+		.from_version = slot_version(SLOT0_ID),
+		.to_version = slot_version(SLOT1_ID),
+	};
+
+	LOG_INF("OTA: %u.%u.%u -> %u.%u.%u, rebooting into MCUboot",
+		pending.from_version >> 24, (pending.from_version >> 16) & 0xffU,
+		pending.from_version & 0xffffU, pending.to_version >> 24,
+		(pending.to_version >> 16) & 0xffU, pending.to_version & 0xffffU);
+
+	/* Last, so that the downtime starts at the reboot */
+	pending.utc_us = utc_time_is_calibrated() ? utc_time_get_us() : 0U;
+	pending.grtc_us = grtc_read_us();
+	(void)retained_blob_write(RETAINED_OTA_OFFSET, &pending, sizeof(pending));
+}
+
+static uint32_t to_ms(uint64_t us)
+{
+	return (uint32_t)MIN(us / 1000U, SESSION_DOWNTIME_UNKNOWN - 1U);
+}
+
+int ota_upgrade_reboot(bool permanent)
+{
+	int err = boot_request_upgrade(permanent ? BOOT_UPGRADE_PERMANENT : BOOT_UPGRADE_TEST);
+
+	if (err) {
+		LOG_ERR("OTA: upgrade request failed (%d)", err);
+		return err;
+	}
+
+	/* The bookkeeping of a requested reset (main.c) */
+	retained_update();
+	status_publish_reset(RESET_EVENT_REQUESTED, true);
+	power_acct_enter_off();
+	boot_flags_set(BOOT_FLAG_RESET_REQUESTED);
+	mono_time_seal();
+
+	stamp();
+	sys_reboot(SYS_REBOOT_COLD);
+	CODE_UNREACHABLE;
+}
+
+#ifdef CONFIG_MCUMGR_GRP_OS_RESET_HOOK
+/* An image uploaded and marked over SMP; the reset runs
+ * CONFIG_MCUMGR_GRP_OS_RESET_MS after this hook, which the downtime
+ * then includes.
+ */
+static enum mgmt_cb_return os_reset_hook(uint32_t event, enum mgmt_cb_return prev_status,
+					 int32_t *rc, uint16_t *group, bool *abort_more,
+					 void *data, size_t data_size)
+{
+	int swap = mcuboot_swap_type();
+
+	if (swap == BOOT_SWAP_TYPE_TEST || swap == BOOT_SWAP_TYPE_PERM) {
+		stamp();
+	}
+
+	return MGMT_CB_OK;
+}
+
+static struct mgmt_callback os_reset_cb = {
+	.callback = os_reset_hook,
+	.event_id = MGMT_EVT_OP_OS_MGMT_RESET,
+};
+#endif /* CONFIG_MCUMGR_GRP_OS_RESET_HOOK */
+
+/* The GRTC restarted during the update: the first calibration gives
+ * the UTC of the boot check, the downtime is its distance to the stamp.
+ */
+static void ota_clock_cb(const struct zbus_channel *chan)
+{
+	const struct clock_state_msg *msg = zbus_chan_const_msg(chan);
+	struct session_entry entry;
+	uint64_t boot_utc_us;
+
+	if (!msg->calibrated || resolve_utc_us == 0U) {
+		return;
+	}
+
+	boot_utc_us = utc_time_from_grtc(check_grtc_us);
+	if (boot_utc_us >= resolve_utc_us && session_hist_get(0, &entry)) {
+		entry.downtime_ms = to_ms(boot_utc_us - resolve_utc_us);
+		session_hist_amend(&entry);
+		LOG_INF("OTA: downtime %u ms (from UTC)", entry.downtime_ms);
+	}
+	resolve_utc_us = 0;
+}
+
+ZBUS_LISTENER_DEFINE(ota_clock_listener, ota_clock_cb);
+
+void ota_boot_check(void)
+{
+	struct ota_pending pending;
+	struct session_entry prev;
+	struct session_entry entry = {
+		.boots = retained.boots,
+		.version = slot_version(SLOT0_ID),
+		.downtime_ms = SESSION_DOWNTIME_UNKNOWN,
+		.kind = SESSION_BOOT,
+	};
+
+	check_grtc_us = grtc_read_us();
+
+	if (retained_blob_read(RETAINED_OTA_OFFSET, &pending, sizeof(pending)) == 0 &&
+	    pending.grtc_us != 0U) {
+		entry.from_version = pending.from_version;
+		entry.kind = (entry.version == pending.to_version) ? SESSION_OTA
+								    : SESSION_OTA_NOT_APPLIED;
+
+		/* As in power_acct_init(): a smaller counter restarted */
+		if (check_grtc_us >= pending.grtc_us) {
+			entry.downtime_ms = to_ms(check_grtc_us - pending.grtc_us);
+		} else if (pending.utc_us != 0U) {
+			resolve_utc_us = pending.utc_us;
+			if (zbus_chan_add_obs(&clock_state_chan, &ota_clock_listener,
+					      K_MSEC(100)) != 0) {
+				resolve_utc_us = 0;
+			}
+		}
+
+		if (entry.kind == SESSION_OTA_NOT_APPLIED) {
+			LOG_WRN("OTA: update to %u.%u.%u not applied", pending.to_version >> 24,
+				(pending.to_version >> 16) & 0xffU, pending.to_version & 0xffffU);
+		} else if (entry.downtime_ms != SESSION_DOWNTIME_UNKNOWN) {
+			LOG_INF("OTA: downtime %u ms", entry.downtime_ms);
+		} else {
+			LOG_WRN("OTA: GRTC restarted, downtime %s", resolve_utc_us != 0U ?
+				"known once UTC is calibrated" : "unknown");
+		}
+
+		memset(&pending, 0, sizeof(pending));
+		(void)retained_blob_write(RETAINED_OTA_OFFSET, &pending, sizeof(pending));
+	} else if (session_hist_get(0, &prev) && prev.version != entry.version) {
+		/* MCUboot reverted a test image, or a debugger flashed one */
+		entry.from_version = prev.version;
+		entry.kind = SESSION_IMAGE_CHANGED;
+	}
+
+	session_hist_record(&entry);
+
+#ifdef CONFIG_APP_OTA_CONFIRM
+	if (!boot_is_img_confirmed()) {
+		int err = boot_write_img_confirmed();
+
+		LOG_INF("OTA: image %sconfirmed", err ? "NOT " : "");
+	}
+#endif
+#ifdef CONFIG_MCUMGR_GRP_OS_RESET_HOOK
+	mgmt_callback_register(&os_reset_cb);
+#endif
+}
+
+void ota_print(void)
+{
+	struct session_entry entry;
+	uint32_t updates = 0;
+	uint32_t min_ms = UINT32_MAX;
+	uint32_t max_ms = 0;
+	uint64_t sum_ms = 0;
+
+	session_hist_print();
+
+	for (uint32_t age = 0; session_hist_get(age, &entry); age++) {
+		if (entry.kind != SESSION_OTA || entry.downtime_ms == SESSION_DOWNTIME_UNKNOWN) {
+			continue;
+		}
+		updates++;
+		min_ms = MIN(min_ms, entry.downtime_ms);
+		max_ms = MAX(max_ms, entry.downtime_ms);
+		sum_ms += entry.downtime_ms;
+	}
+
+	if (updates == 0U) {
+		LOG_INF("OTA downtime: no updates measured");
+		return;
+	}
+
+	LOG_INF("OTA downtime: %u updates, min %u mean %llu max %u ms",
+		updates, min_ms, sum_ms / updates, max_ms);
+}
@@ -0,0 +1,55 @@
+/*
+ * Firmware update downtime - Header File
+ *
+ * Before the reboot that lets MCUboot swap in a new image the GRTC,
+ * UTC and the versions of both slots are stamped into the retained
+ * region (window RETAINED_OTA_OFFSET).  MCUboot leaves the GRTC
+ * running, so the new image takes the downtime - swap plus boot up to
+ * ota_boot_check() - from the GRTC.  If the GRTC restarted on the way
+ * (power loss during the swap) the downtime is taken from UTC once the
+ * clock is calibrated again.  Every boot goes into the session
+ * history (session_hist.h) with its image version; a boot into the
+ * requested image also with the version it replaced and the downtime.
+ *
+ * Upgrade reboots are stamped by ota_upgrade_reboot() and, with the
+ * MCUmgr OS group, by a reset hook when an update is pending.
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdbool.h>
+
+#ifdef CONFIG_APP_OTA_DOWNTIME
+
+/**
+ * @brief Mark the image in the secondary slot for swap and reboot
+ *
+ * @param permanent false for a test swap that MCUboot reverts unless
+ * the new image confirms itself
+ * @return Negative errno if the upgrade could not be requested; does
+ * not return otherwise
+ */
+int ota_upgrade_reboot(bool permanent);
+
+/**
+ * @brief Account a pending update at boot and record the session
+ *
+ * Call once at boot, after the UTC calibration was restored.
+ */
+void ota_boot_check(void);
+
+/**
+ * @brief Log the session history and the downtime statistics of the
+ * updates in it
+ */
+void ota_print(void);
+
+#else
+
+static inline void ota_boot_check(void) {}
+static inline void ota_print(void) {}
+
+#endif /* CONFIG_APP_OTA_DOWNTIME */
+
+#endif /* OTA_H */
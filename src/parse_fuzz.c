@@ -0,0 +1,353 @@
+/*
+ * RFC 3339 parser fuzzing
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include "parse_fuzz.h"
+#include "utc_time.h"
+
+LOG_MODULE_REGISTER(parse_fuzz, LOG_LEVEL_INF);
+
+#define FUZZ_MAX_LEN 48
+
+static const char *const seeds[] = {
+	"1970-01-01T00:00:00Z",
+	"2025-12-11T08:30:00.250Z",
+	"2024-02-29T12:00:00.5z",
+	"2025-12-11t08:30:00.123456789+05:30",
+	"2016-12-31 23:59:60-00:00",
+	"1970-01-01T00:30:00+00:30",
+	"9999-12-31T23:59:59.999999Z",
+	"2023-02-29T00:00:00Z",
+	"2025-12-11T08:30:00.Z",
+	"2025-12-11T08:30:00+0530",
+};
+
+/* Characters that make up timestamps, and some that never do */
+static const char alphabet[] = "0123456789-:.+TtZz 0123456789\x00\xff/x";
+
+static uint32_t xorshift_state = 88172645U;
+
+static uint32_t fuzz_rand(void)
+{
+	xorshift_state ^= xorshift_state << 13;
+	xorshift_state ^= xorshift_state >> 17;
+	xorshift_state ^= xorshift_state << 5;
+	return xorshift_state;
+}
+
+static char fuzz_char(void)
+{
+	return alphabet[fuzz_rand() % (sizeof(alphabet) - 1U)];
+}
+
+/* Reference parser: a template match, then day counting by walking
+ * years and months.  Slow, but written without the parser's tricks.
+ */
+static bool ref_leap(int y)
+{
+	return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static int ref_month_days(int y, int m)
+{
+	switch (m) {
+	case 2:
+		return ref_leap(y) ? 29 : 28;
+	case 4: case 6: case 9: case 11:
+		return 30;
+	default:
+		return 31;
+	}
+}
+
+static int ref_number(const char *s, size_t n)
+{
+	int v = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		v = v * 10 + (s[i] - '0');
+	}
+	return v;
+}
+
+static bool ref_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static int ref_parse(const char *s, size_t len, uint64_t *out)
+{
+	static const char template[] = "####-##-##T##:##:##";
+	static const int32_t frac_scale[6] = { 100000, 10000, 1000, 100, 10, 1 };
+	size_t i;
+	int64_t frac = 0;
+	int64_t offset_s = 0;
+
+	if (len < sizeof(template) - 1U) {
+		return -EINVAL;
+	}
+	for (i = 0; i < sizeof(template) - 1U; i++) {
+		char t = template[i];
+		bool ok = (t == '#') ? ref_digit(s[i]) :
+			  (t == 'T') ? (s[i] == 'T' || s[i] == 't' || s[i] == ' ') :
+			  (s[i] == t);
+
+		if (!ok) {
+			return -EINVAL;
+		}
+	}
+
+	int year = ref_number(s, 4);
+	int month = ref_number(s + 5, 2);
+	int day = ref_number(s + 8, 2);
+	int hour = ref_number(s + 11, 2);
+	int minute = ref_number(s + 14, 2);
+	int second = ref_number(s + 17, 2);
+
+	if (year < 1970 || month < 1 || month > 12 || day < 1 ||
+	    day > ref_month_days(year, month) || hour > 23 || minute > 59 || second > 60) {
+		return -EINVAL;
+	}
+
+	if (i < len && s[i] == '.') {
+		size_t first = ++i;
+
+		while (i < len && ref_digit(s[i])) {
+			if (i - first < 6U) {
+				frac += (s[i] - '0') * frac_scale[i - first];
+			}
+			i++;
+		}
+		if (i == first) {
+			return -EINVAL;
+		}
+	}
+
+	if (i < len && (s[i] == 'Z' || s[i] == 'z')) {
+		i++;
+	} else if (i + 6U <= len && (s[i] == '+' || s[i] == '-') &&
+		   ref_digit(s[i + 1]) && ref_digit(s[i + 2]) && s[i + 3] == ':' &&
+		   ref_digit(s[i + 4]) && ref_digit(s[i + 5])) {
+		int h = ref_number(s + i + 1, 2);
+		int m = ref_number(s + i + 4, 2);
+
+		if (h > 23 || m > 59) {
+			return -EINVAL;
+		}
+		offset_s = (h * 60 + m) * 60;
+		if (s[i] == '-') {
+			offset_s = -offset_s;
+		}
+		i += 6;
+	} else {
+		return -EINVAL;
+	}
+
+	if (i != len) {
+		return -EINVAL;
+	}
+
+	int64_t days = day - 1;
+
+	for (int y = 1970; y < year; y++) {
+		days += ref_leap(y) ? 366 : 365;
+	}
+	for (int m = 1; m < month; m++) {
+		days += ref_month_days(year, m);
+	}
+
+	int64_t sec = days * 86400 + hour * 3600 + minute * 60 + second - offset_s;
+
+	if (sec < 0) {
+		return -EINVAL;
+	}
+
+	*out = (uint64_t)sec * 1000000U + (uint64_t)frac;
+	return 0;
+}
+
+/* Input at the very end of the buffer: no terminator, no slack */
+static char input[FUZZ_MAX_LEN];
+
+static const char *place(const char *s, size_t len)
+{
+	char *p = input + sizeof(input) - len;
+
+	memmove(p, s, len);
+	return p;
+}
+
+static bool round_trip(void)
+{
+	uint64_t us = ((uint64_t)fuzz_rand() << 32 | fuzz_rand()) %
+		      ((UTC_TIME_ISO_MAX_SEC + 1U) * 1000000U);
+	int32_t offset_min = 0;
+	char buf[FUZZ_MAX_LEN];
+	uint64_t local_us;
+	uint64_t parsed;
+	int len;
+
+	/* Offsets only where the local time is still 1970..9999 */
+	if (fuzz_rand() & 1U) {
+		offset_min = (int32_t)(fuzz_rand() % (2 * 1440 - 1)) - 1439;
+	}
+	local_us = us + (int64_t)offset_min * 60 * 1000000;
+	if ((int64_t)local_us < 0 || local_us / 1000000U > UTC_TIME_ISO_MAX_SEC) {
+		offset_min = 0;
+		local_us = us;
+	}
+
+	len = utc_time_format_iso_us(local_us, buf, sizeof(buf));
+	if (len != 27) {
+		return false;
+	}
+
+	/* 0..9 fraction digits; more than six are truncated */
+	uint32_t digits = fuzz_rand() % 10U;
+	uint64_t expect = us - (local_us % 1000000U);
+
+	if (digits == 0U) {
+		len = 19;
+	} else {
+		uint32_t keep = MIN(digits, 6U);
+		uint32_t scale = 1;
+
+		for (uint32_t i = keep; i < 6U; i++) {
+			scale *= 10U;
+		}
+		expect += (local_us % 1000000U) / scale * scale;
+		len = 20 + (int)keep;
+		for (uint32_t i = keep; i < digits; i++) {
+			buf[len++] = '0' + fuzz_rand() % 10U;
+		}
+	}
+
+	if (offset_min == 0 && (fuzz_rand() & 1U)) {
+		buf[len++] = (fuzz_rand() & 1U) ? 'Z' : 'z';
+	} else {
+		uint32_t a = (uint32_t)(offset_min < 0 ? -offset_min : offset_min);
+
+		len += snprintk(buf + len, sizeof(buf) - len, "%c%02u:%02u",
+				offset_min < 0 ? '-' : '+', a / 60U, a % 60U);
+	}
+
+	if (utc_time_parse_rfc3339(place(buf, len), len, &parsed) != 0 || parsed != expect) {
+		LOG_ERR("Parse fuzz: round trip of %.*s gave %llu, expected %llu", len, buf,
+			parsed, expect);
+		return false;
+	}
+
+	return true;
+}
+
+static size_t mutate(char *buf, size_t len)
+{
+	uint32_t n = 1U + fuzz_rand() % 3U;
+
+	for (uint32_t k = 0; k < n; k++) {
+		size_t at = (len != 0U) ? fuzz_rand() % len : 0U;
+
+		switch (fuzz_rand() % 5U) {
+		case 0: /* replace */
+			if (len != 0U) {
+				buf[at] = fuzz_char();
+			}
+			break;
+		case 1: /* random byte */
+			if (len != 0U) {
+				buf[at] = (char)fuzz_rand();
+			}
+			break;
+		case 2: /* insert */
+			if (len < FUZZ_MAX_LEN) {
+				memmove(buf + at + 1, buf + at, len - at);
+				buf[at] = fuzz_char();
+				len++;
+			}
+			break;
+		case 3: /* delete */
+			if (len != 0U) {
+				memmove(buf + at, buf + at + 1, len - at - 1);
+				len--;
+			}
+			break;
+		default: /* truncate */
+			len = at;
+			break;
+		}
+	}
+
+	return len;
+}
+
+/* Both parsers must agree; returns false on a mismatch */
+static bool differential(const char *buf, size_t len, uint32_t *accepted)
+{
+	uint64_t us = 0;
+	uint64_t ref_us = 0;
+	int err = utc_time_parse_rfc3339(place(buf, len), len, &us);
+	int ref_err = ref_parse(buf, len, &ref_us);
+
+	if ((err == 0) != (ref_err == 0) || (err == 0 && us != ref_us)) {
+		LOG_ERR("Parse fuzz: %.*s: parser %d (%llu), reference %d (%llu)", (int)len,
+			buf, err, us, ref_err, ref_us);
+		return false;
+	}
+
+	*accepted += (err == 0) ? 1U : 0U;
+	return true;
+}
+
+int parse_fuzz_run(void)
+{
+	const uint32_t n = CONFIG_APP_PARSE_FUZZ_ITERATIONS;
+	uint32_t failed = 0;
+	uint32_t mutated_ok = 0;
+	uint32_t random_ok = 0;
+	char buf[FUZZ_MAX_LEN];
+	size_t len;
+
+	LOG_INF("=== Parse fuzz: %u inputs per pass ===", n);
+
+	/* The seeds themselves, then the passes */
+	for (size_t i = 0; i < ARRAY_SIZE(seeds); i++) {
+		uint32_t ignored = 0;
+
+		failed += differential(seeds[i], strlen(seeds[i]), &ignored) ? 0U : 1U;
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		failed += round_trip() ? 0U : 1U;
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		const char *seed = seeds[fuzz_rand() % ARRAY_SIZE(seeds)];
+
+		len = strlen(seed);
+		memcpy(buf, seed, len);
+		len = mutate(buf, len);
+		failed += differential(buf, len, &mutated_ok) ? 0U : 1U;
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		len = fuzz_rand() % (FUZZ_MAX_LEN + 1U);
+		for (size_t k = 0; k < len; k++) {
+			buf[k] = fuzz_char();
+		}
+		failed += differential(buf, len, &random_ok) ? 0U : 1U;
+	}
+
+	LOG_INF("Parse fuzz: %u round trips, %u mutated (%u accepted), %u random (%u accepted)",
+		n, n, mutated_ok, n, random_ok);
+
+	if (failed != 0U) {
+		LOG_ERR("Parse fuzz: FAIL (%u)", failed);
+		return -EIO;
+	}
+
+	LOG_INF("Parse fuzz: PASS");
+	return 0;
+}
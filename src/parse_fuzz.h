@@ -0,0 +1,38 @@
+/*
+ * RFC 3339 parser fuzzing - Header File
+ *
+ * native_sim harness for utc_time_parse_rfc3339():
+ *
+ *   round trip - random instants 1970..9999 rendered with
+ *                utc_time_format_iso_us(), with 'Z' or a random
+ *                +HH:MM / -HH:MM offset and 0..9 fraction digits,
+ *                must parse back to the same microsecond
+ *   mutated    - valid and invalid seeds with random byte changes,
+ *                insertions, deletions and truncations
+ *   random     - strings drawn from the timestamp alphabet
+ *
+ * Mutated and random inputs are also fed to a slow reference parser
+ * written from the grammar; both must agree on accept / reject and on
+ * the value.  Each input is passed with its exact length in a buffer
+ * without a terminator, so reads past the end show up under ASan.
+ */
+
+#ifndef PARSE_FUZZ_H
+#define PARSE_FUZZ_H
+
+#ifdef CONFIG_APP_PARSE_FUZZ
+
+/**
+ * @brief Run the fuzz passes and log the result
+ *
+ * @return 0 if every check passed, -EIO otherwise
+ */
+int parse_fuzz_run(void);
+
+#else
+
+static inline int parse_fuzz_run(void) { return 0; }
+
+#endif /* CONFIG_APP_PARSE_FUZZ */
+
+#endif /* PARSE_FUZZ_H */
@@ -0,0 +1,135 @@
+/*
+ * Time-in-state accounting
+ *
+ * Running and idle time come from the scheduler's thread usage
+ * statistics (the idle threads' cycles), low-power time from PM
+ * notifier timestamps taken with the GRTC.  Low-power states are
+ * entered from the idle thread, so that time is moved out of idle.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "power_acct.h"
+#include "retained.h"
+#include "grtc.h"
+
+#ifdef CONFIG_PM
+#include <zephyr/pm/pm.h>
+#endif
+
+LOG_MODULE_REGISTER(power_acct, LOG_LEVEL_INF);
+
+/* Session totals already folded into the retained counters */
+static uint64_t folded_run_us;
+static uint64_t folded_idle_us;
+static uint64_t folded_lowpower_us;
+
+#ifdef CONFIG_PM
+/* Only touched from the idle thread with interrupts locked */
+static uint64_t lowpower_us;
+static uint64_t lowpower_entry;
+
+static void pm_state_entry(enum pm_state state)
+{
+	ARG_UNUSED(state);
+	lowpower_entry = grtc_read_us();
+}
+
+static void pm_state_exit(enum pm_state state)
+{
+	ARG_UNUSED(state);
+	lowpower_us += grtc_read_us() - lowpower_entry;
+}
+
+static struct pm_notifier power_acct_notifier = {
+	.state_entry = pm_state_entry,
+	.state_exit = pm_state_exit,
+};
+#endif /* CONFIG_PM */
+
+void power_acct_init(void)
+{
+	uint64_t now = grtc_read_us();
+
+	/* The GRTC keeps counting through System OFF and soft resets;
+	 * if it restarted, the length of the gap is unknown.
+	 */
+	if (retained.off_entry_grtc != 0U) {
+		if (now >= retained.off_entry_grtc) {
+			retained.off_us += now - retained.off_entry_grtc;
+		} else {
+			LOG_WRN("GRTC restarted, off time of last gap unknown");
+		}
+		retained.off_entry_grtc = 0;
+	}
+
+#ifdef CONFIG_PM
+	pm_notifier_register(&power_acct_notifier);
+#endif
+}
+
+/* Add what a session total gained since it was last folded.  Idle
+ * minus low-power time can step back when a low-power period has been
+ * timed but the idle thread's cycles for it are not yet counted; the
+ * total is then left alone until it has caught up again.
+ */
+static void fold(uint64_t *counter, uint64_t *folded, uint64_t total)
+{
+	if (total > *folded) {
+		*counter += total - *folded;
+		*folded = total;
+	}
+}
+
+void power_acct_update(void)
+{
+	k_thread_runtime_stats_t all;
+	uint64_t idle_us, lp_us = 0;
+
+	if (k_thread_runtime_stats_all_get(&all) != 0) {
+		return;
+	}
+
+	idle_us = k_cyc_to_us_floor64(all.idle_cycles);
+#ifdef CONFIG_PM
+	unsigned int key = irq_lock();
+
+	lp_us = lowpower_us;
+	irq_unlock(key);
+#endif
+	idle_us = (idle_us > lp_us) ? idle_us - lp_us : 0;
+
+	uint64_t run_us = k_cyc_to_us_floor64(all.execution_cycles - all.idle_cycles);
+
+	fold(&retained.run_us, &folded_run_us, run_us);
+	fold(&retained.idle_us, &folded_idle_us, idle_us);
+	fold(&retained.lowpower_us, &folded_lowpower_us, lp_us);
+}
+
+void power_acct_enter_off(void)
+{
+	retained.off_entry_grtc = grtc_read_us();
+	retained_update();
+}
+
+/* x as a per-mille share of total, for logging */
+static uint32_t permille(uint64_t x, uint64_t total)
+{
+	return (total != 0U) ? (uint32_t)(x * 1000U / total) : 0U;
+}
+
+void power_acct_print(void)
+{
+	uint64_t total = retained.run_us + retained.idle_us +
+			 retained.lowpower_us + retained.off_us;
+	uint32_t run = permille(retained.run_us, total);
+	uint32_t idle = permille(retained.idle_us, total);
+	uint32_t lp = permille(retained.lowpower_us, total);
+	uint32_t off = permille(retained.off_us, total);
+
+	LOG_INF("=== Time in state (all sessions) ===");
+	LOG_INF("  run:       %llu ms (%u.%u%%)", retained.run_us / 1000U, run / 10U, run % 10U);
+	LOG_INF("  idle:      %llu ms (%u.%u%%)", retained.idle_us / 1000U, idle / 10U, idle % 10U);
+	LOG_INF("  low power: %llu ms (%u.%u%%)", retained.lowpower_us / 1000U, lp / 10U, lp % 10U);
+	LOG_INF("  off/reset: %llu ms (%u.%u%%)", retained.off_us / 1000U, off / 10U, off % 10U);
+}
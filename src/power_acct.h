@@ -0,0 +1,51 @@
+/*
+ * Time-in-state accounting - Header File
+ *
+ * Splits the time of every session into running, idle and low-power
+ * (Zephyr PM states) and adds the gaps spent in System OFF or reset,
+ * accumulating all of it in struct retained_data.  Together these give
+ * a persistent duty-cycle profile of the device.
+ */
+
+#ifndef POWER_ACCT_H
+#define POWER_ACCT_H
+
+#ifdef CONFIG_APP_POWER_ACCT
+
+/**
+ * @brief Account the gap since the previous session ended
+ *
+ * Call once after retained_validate().
+ */
+void power_acct_init(void);
+
+/**
+ * @brief Fold this session's time-in-state into the retained totals
+ *
+ * Called by retained_update(); the caller persists the result.
+ */
+void power_acct_update(void);
+
+/**
+ * @brief Mark the start of System OFF or a reset
+ *
+ * Stamps the GRTC and persists the retained data.  Call right before
+ * sys_poweroff() or sys_reboot().
+ */
+void power_acct_enter_off(void);
+
+/**
+ * @brief Log the cumulative duty-cycle profile
+ */
+void power_acct_print(void);
+
+#else
+
+static inline void power_acct_init(void) {}
+static inline void power_acct_update(void) {}
+static inline void power_acct_enter_off(void) {}
+static inline void power_acct_print(void) {}
+
+#endif /* CONFIG_APP_POWER_ACCT */
+
+#endif /* POWER_ACCT_H */
@@ -0,0 +1,307 @@
+/*
+ * 1PPS output aligned to UTC
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <nrfx_gpiote.h>
+#include <helpers/nrfx_gppi.h>
+#include <hal/nrf_grtc.h>
+#include "pps.h"
+#include "grtc_trigger.h"
+#include "latency_hist.h"
+#include "status.h"
+#include "utc_time.h"
+
+LOG_MODULE_REGISTER(pps, LOG_LEVEL_INF);
+
+#define PPS_PERIOD_US (1000000U / CONFIG_APP_PPS_RATE_HZ)
+
+/* Arm the first edge at least this far ahead of the current time */
+#define PPS_LEAD_US 1000U
+
+/* Log the edge statistics every this many pulses */
+#define PPS_REPORT_PULSES (10U * CONFIG_APP_PPS_RATE_HZ)
+
+/* A measured pulse width further than this from the configured one
+ * counts as off
+ */
+#define PPS_WIDTH_TOLERANCE_US 10U
+
+BUILD_ASSERT(1000000U % CONFIG_APP_PPS_RATE_HZ == 0,
+	     "CONFIG_APP_PPS_RATE_HZ must divide one second");
+BUILD_ASSERT(CONFIG_APP_PPS_WIDTH_US < PPS_PERIOD_US,
+	     "CONFIG_APP_PPS_WIDTH_US must be shorter than the period");
+
+static const nrfx_gpiote_t gpiote = NRFX_GPIOTE_INSTANCE(CONFIG_APP_PPS_GPIOTE_INSTANCE);
+
+static struct grtc_trigger rise;
+static struct grtc_trigger fall;
+
+/* UTC and GRTC of the armed rising edge */
+static uint64_t edge_utc;
+static uint64_t edge_grtc;
+static bool running;
+static uint32_t pulses;
+
+/* |captured - intended| per edge in microseconds */
+static LATENCY_HIST_DEFINE(edge_error_hist);
+
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+/* Captures both edges of the loopback input in turn */
+static int32_t capture_chan = -1;
+
+/* Rising edge of the current pulse, and the measured high times */
+static uint64_t rise_captured;
+static bool rise_valid;
+static uint32_t width_min = UINT32_MAX;
+static uint32_t width_max;
+static uint32_t widths;
+static uint32_t widths_off;
+#endif
+
+static void report_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+	pps_print();
+}
+
+static K_WORK_DEFINE(report_work, report_work_handler);
+
+static void rise_handler(int32_t id, uint64_t cc_value, void *user_data);
+static void fall_handler(int32_t id, uint64_t cc_value, void *user_data);
+
+/* Program both compares of the pulse starting at utc_us.  The next
+ * pulse is armed from the fall compare, once both of these have fired:
+ * re-arming a pending compare would replace it.
+ */
+static int arm(uint64_t utc_us)
+{
+	uint64_t grtc;
+	int err = utc_time_to_grtc(utc_us, &grtc);
+
+	if (err) {
+		return err;
+	}
+
+	edge_utc = utc_us;
+	edge_grtc = grtc;
+
+	err = grtc_trigger_arm(&rise, grtc,
+			       (CONFIG_APP_PPS_LOOPBACK_PIN >= 0) ? rise_handler : NULL, NULL);
+	if (err == 0) {
+		err = grtc_trigger_arm(&fall, grtc + CONFIG_APP_PPS_WIDTH_US, fall_handler,
+				       NULL);
+	}
+
+	return err;
+}
+
+/* Rising edge compare, with the loopback only */
+static void rise_handler(int32_t id, uint64_t cc_value, void *user_data)
+{
+	ARG_UNUSED(id);
+	ARG_UNUSED(cc_value);
+	ARG_UNUSED(user_data);
+
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+	/* Against the UTC instant the edge was meant for, not the compare
+	 * value, so that errors of the UTC to GRTC conversion count too
+	 */
+	rise_valid = (z_nrf_grtc_timer_capture_read(capture_chan, &rise_captured) == 0);
+	if (rise_valid) {
+		uint64_t utc = utc_time_from_grtc(rise_captured);
+		uint64_t error = (utc > edge_utc) ? utc - edge_utc : edge_utc - utc;
+
+		latency_hist_record(&edge_error_hist, (uint32_t)MIN(error, UINT32_MAX));
+	}
+	(void)z_nrf_grtc_timer_capture_prepare(capture_chan);
+#endif
+}
+
+/* Falling edge compare: the pulse is complete, arm the next one */
+static void fall_handler(int32_t id, uint64_t cc_value, void *user_data)
+{
+	ARG_UNUSED(id);
+	ARG_UNUSED(cc_value);
+	ARG_UNUSED(user_data);
+
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+	uint64_t captured;
+
+	if (rise_valid && z_nrf_grtc_timer_capture_read(capture_chan, &captured) == 0 &&
+	    captured > rise_captured) {
+		uint32_t width = (uint32_t)MIN(captured - rise_captured, UINT32_MAX);
+		uint32_t off = (width > CONFIG_APP_PPS_WIDTH_US) ?
+			       width - CONFIG_APP_PPS_WIDTH_US : CONFIG_APP_PPS_WIDTH_US - width;
+
+		width_min = MIN(width_min, width);
+		width_max = MAX(width_max, width);
+		widths++;
+		widths_off += (off > PPS_WIDTH_TOLERANCE_US) ? 1U : 0U;
+	}
+	rise_valid = false;
+	(void)z_nrf_grtc_timer_capture_prepare(capture_chan);
+#endif
+
+	if (++pulses % PPS_REPORT_PULSES == 0U) {
+		k_work_submit(&report_work);
+	}
+
+	if (running && arm(edge_utc + PPS_PERIOD_US) != 0) {
+		running = false;
+	}
+}
+
+/* (Re)start the pulse train from the current calibration */
+static void restart(bool calibrated)
+{
+	unsigned int key = irq_lock();
+
+	grtc_trigger_cancel(&rise);
+	grtc_trigger_cancel(&fall);
+
+	/* End a pulse cut short by the cancelled fall compare */
+	nrfx_gpiote_clr_task_trigger(&gpiote, CONFIG_APP_PPS_PIN);
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+	rise_valid = false;
+	(void)z_nrf_grtc_timer_capture_prepare(capture_chan);
+#endif
+
+	running = false;
+	if (calibrated) {
+		uint64_t now = utc_time_get_us();
+		uint64_t next = (now / PPS_PERIOD_US + 1U) * PPS_PERIOD_US;
+
+		if (next - now < PPS_LEAD_US) {
+			next += PPS_PERIOD_US;
+		}
+
+		running = (arm(next) == 0);
+	}
+
+	irq_unlock(key);
+}
+
+static void pps_clock_cb(const struct zbus_channel *chan)
+{
+	const struct clock_state_msg *msg = zbus_chan_const_msg(chan);
+
+	restart(msg->calibrated);
+}
+
+ZBUS_LISTENER_DEFINE(pps_clock_listener, pps_clock_cb);
+
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+/* Loopback input edges -> GRTC capture, read by the compare handlers */
+static int loopback_init(void)
+{
+	uint8_t in_channel;
+	uint8_t ppi;
+	nrfx_gpiote_trigger_config_t trigger_config = {
+		.trigger = NRFX_GPIOTE_TRIGGER_TOGGLE,
+		.p_in_channel = &in_channel,
+	};
+	nrfx_gpiote_input_pin_config_t input_config = {
+		.p_trigger_config = &trigger_config,
+	};
+
+	capture_chan = z_nrf_grtc_timer_chan_alloc();
+	if (capture_chan < 0 ||
+	    nrfx_gpiote_channel_alloc(&gpiote, &in_channel) != NRFX_SUCCESS ||
+	    nrfx_gppi_channel_alloc(&ppi) != NRFX_SUCCESS) {
+		return -ENOMEM;
+	}
+
+	if (nrfx_gpiote_input_configure(&gpiote, CONFIG_APP_PPS_LOOPBACK_PIN,
+					&input_config) != NRFX_SUCCESS) {
+		return -EIO;
+	}
+	nrfx_gpiote_trigger_enable(&gpiote, CONFIG_APP_PPS_LOOPBACK_PIN, false);
+
+	nrfx_gppi_channel_endpoints_setup(ppi,
+		nrfx_gpiote_in_event_address_get(&gpiote, CONFIG_APP_PPS_LOOPBACK_PIN),
+		nrf_grtc_task_address_get(NRF_GRTC,
+					  nrf_grtc_sys_counter_capture_task_get(capture_chan)));
+	nrfx_gppi_channels_enable(BIT(ppi));
+
+	return z_nrf_grtc_timer_capture_prepare(capture_chan);
+}
+#endif
+
+int pps_init(void)
+{
+	static const nrfx_gpiote_output_config_t output_config =
+		NRFX_GPIOTE_DEFAULT_OUTPUT_CONFIG;
+	uint8_t out_channel;
+	int err;
+
+	if (!nrfx_gpiote_init_check(&gpiote) &&
+	    nrfx_gpiote_init(&gpiote, 0) != NRFX_SUCCESS) {
+		return -EIO;
+	}
+
+	if (nrfx_gpiote_channel_alloc(&gpiote, &out_channel) != NRFX_SUCCESS) {
+		return -ENOMEM;
+	}
+
+	nrfx_gpiote_task_config_t task_config = {
+		.task_ch = out_channel,
+		.polarity = NRF_GPIOTE_POLARITY_TOGGLE,
+		.init_val = NRF_GPIOTE_INITIAL_VALUE_LOW,
+	};
+
+	if (nrfx_gpiote_output_configure(&gpiote, CONFIG_APP_PPS_PIN, &output_config,
+					 &task_config) != NRFX_SUCCESS) {
+		return -EIO;
+	}
+	nrfx_gpiote_out_task_enable(&gpiote, CONFIG_APP_PPS_PIN);
+
+	err = grtc_trigger_init(&rise,
+		nrfx_gpiote_set_task_address_get(&gpiote, CONFIG_APP_PPS_PIN));
+	if (err == 0) {
+		err = grtc_trigger_init(&fall,
+			nrfx_gpiote_clr_task_address_get(&gpiote, CONFIG_APP_PPS_PIN));
+	}
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+	if (err == 0) {
+		err = loopback_init();
+	}
+#endif
+	if (err) {
+		LOG_ERR("PPS setup failed (%d)", err);
+		return err;
+	}
+
+	err = zbus_chan_add_obs(&clock_state_chan, &pps_clock_listener, K_MSEC(100));
+	if (err) {
+		return err;
+	}
+
+	restart(utc_time_is_calibrated());
+	LOG_INF("PPS: %u Hz, %u us pulses on pin %u (%s)", CONFIG_APP_PPS_RATE_HZ,
+		CONFIG_APP_PPS_WIDTH_US, CONFIG_APP_PPS_PIN,
+		running ? "running" : "waiting for calibration");
+
+	return 0;
+}
+
+void pps_print(void)
+{
+	if (latency_hist_count(&edge_error_hist) == 0U) {
+		LOG_INF("PPS: %u pulses, next edge UTC %llu us (GRTC %llu)",
+			pulses, edge_utc, edge_grtc);
+		return;
+	}
+
+	LOG_INF("PPS: %u pulses, edge error p50 %u, p99 %u, max %u us", pulses,
+		latency_hist_percentile(&edge_error_hist, 500),
+		latency_hist_percentile(&edge_error_hist, 990),
+		latency_hist_max(&edge_error_hist));
+#if CONFIG_APP_PPS_LOOPBACK_PIN >= 0
+	LOG_INF("PPS: high %u..%u us (%u measured, %u off by more than %u us)",
+		(widths != 0U) ? width_min : 0U, width_max, widths, widths_off,
+		PPS_WIDTH_TOLERANCE_US);
+#endif
+}
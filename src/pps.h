@@ -0,0 +1,43 @@
+/*
+ * 1PPS output aligned to UTC - Header File
+ *
+ * Drives a GPIO with CONFIG_APP_PPS_RATE_HZ pulses per second whose
+ * rising edges fall on multiples of the period in UTC.  Each edge is a
+ * GRTC compare routed over (D)PPI to a GPIOTE SET task and the end of
+ * the pulse a second compare to the CLR task (grtc_trigger.h), so the
+ * edge timing does not depend on the CPU.  The CPU only re-arms the
+ * next pulse from the end of the current one, computing its compare
+ * values from the current calibration (utc_time_to_grtc()), and
+ * restarts the train when the clock is recalibrated.
+ *
+ * With CONFIG_APP_PPS_LOOPBACK_PIN wired to the output, both edges are
+ * also captured by the GRTC: the rising edge is compared with its
+ * intended instant, the falling edge gives the measured high time.
+ */
+
+#ifndef PPS_H
+#define PPS_H
+
+#ifdef CONFIG_APP_PPS
+
+/**
+ * @brief Configure the output and start pulsing once calibrated
+ *
+ * @return 0 on success, negative errno if a GRTC, PPI or GPIOTE
+ * channel could not be allocated
+ */
+int pps_init(void);
+
+/**
+ * @brief Log the pulse count and the measured edge error
+ */
+void pps_print(void);
+
+#else
+
+static inline int pps_init(void) { return 0; }
+static inline void pps_print(void) {}
+
+#endif /* CONFIG_APP_PPS */
+
+#endif /* PPS_H */
@@ -0,0 +1,179 @@
+/*
+ * Scoped code-section profiler
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/timing/timing.h>
+#include <stdio.h>
+#include "profile.h"
+#include "latency_hist.h"
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(profile, LOG_LEVEL_INF);
+
+#define PROFILE_CALIBRATION_ROUNDS 256
+
+struct profile_site {
+	const char *name;
+	uint64_t total;                 /* Cycles, protected by profile_lock */
+	struct latency_hist hist;       /* Cycles per call */
+};
+
+static struct profile_site sites[PROFILE_COUNT] = {
+#define PROFILE_INIT(id, site_name) [PROFILE_##id] = { .name = site_name },
+	PROFILE_SITES(PROFILE_INIT)
+#undef PROFILE_INIT
+};
+
+static struct k_spinlock profile_lock;
+
+/* Duration an empty scope records, in cycles: the counter read on
+ * entry and the call into profile_scope_exit()
+ */
+static uint32_t profile_overhead;
+
+void profile_scope_exit(struct profile_scope *scope)
+{
+	timing_t end = timing_counter_get();
+	struct profile_site *site = &sites[scope->id];
+	uint64_t cycles = timing_cycles_get(&scope->start, &end);
+
+	cycles = (cycles > profile_overhead) ? (cycles - profile_overhead) : 0;
+
+	latency_hist_record(&site->hist, (uint32_t)MIN(cycles, UINT32_MAX));
+
+	k_spinlock_key_t key = k_spin_lock(&profile_lock);
+
+	site->total += cycles;
+	k_spin_unlock(&profile_lock, key);
+}
+
+void profile_reset(void)
+{
+	for (size_t i = 0; i < PROFILE_COUNT; i++) {
+		k_spinlock_key_t key = k_spin_lock(&profile_lock);
+
+		sites[i].total = 0;
+		k_spin_unlock(&profile_lock, key);
+		latency_hist_reset(&sites[i].hist);
+	}
+}
+
+/* Site indices ordered by total time, largest first */
+static void profile_sort(uint8_t order[PROFILE_COUNT])
+{
+	for (size_t i = 0; i < PROFILE_COUNT; i++) {
+		size_t j = i;
+
+		while (j > 0 && sites[order[j - 1]].total < sites[i].total) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = (uint8_t)i;
+	}
+}
+
+#define PROFILE_HEADER_FMT "%-20s %8s %10s %7s %7s %7s %7s"
+#define PROFILE_HEADER_ARGS "site", "count", "total", "mean", "min", "p99", "max"
+
+/* Render one site as a table row; returns false for sites never hit */
+static bool profile_format_row(const struct profile_site *site, char *buf, size_t size)
+{
+	uint32_t count = latency_hist_count(&site->hist);
+
+	if (count == 0U) {
+		return false;
+	}
+
+	snprintf(buf, size, "%-20s %8u %10llu %7llu %7llu %7llu %7llu",
+		 site->name, count,
+		 timing_cycles_to_ns(site->total),
+		 timing_cycles_to_ns(site->total / count),
+		 timing_cycles_to_ns(latency_hist_min(&site->hist)),
+		 timing_cycles_to_ns(latency_hist_percentile(&site->hist, 990)),
+		 timing_cycles_to_ns(latency_hist_max(&site->hist)));
+	return true;
+}
+
+void profile_dump(void)
+{
+	uint8_t order[PROFILE_COUNT];
+	char row[96];
+
+	profile_sort(order);
+
+	LOG_INF("=== Profile (ns, overhead %u cycles subtracted) ===", profile_overhead);
+	LOG_INF(PROFILE_HEADER_FMT, PROFILE_HEADER_ARGS);
+
+	for (size_t i = 0; i < PROFILE_COUNT; i++) {
+		if (profile_format_row(&sites[order[i]], row, sizeof(row))) {
+			LOG_INF("%s", row);
+		}
+	}
+}
+
+static int profile_init(void)
+{
+	struct profile_site *site = &sites[PROFILE_CALIBRATION];
+
+	timing_init();
+	timing_start();
+
+	/* Time empty scopes through the real entry and cleanup path, with
+	 * nothing subtracted yet: the smallest duration they record is the
+	 * fixed cost that every scope adds on top of the profiled code.
+	 */
+	profile_overhead = 0;
+	for (int i = 0; i < PROFILE_CALIBRATION_ROUNDS; i++) {
+		PROFILE_SCOPE(CALIBRATION);
+	}
+
+	profile_overhead = latency_hist_min(&site->hist);
+
+	/* Hidden from the dump again */
+	site->total = 0;
+	latency_hist_reset(&site->hist);
+	return 0;
+}
+
+SYS_INIT(profile_init, APPLICATION, 0);
+
+#ifdef CONFIG_SHELL
+static int cmd_profile_show(const struct shell *sh, size_t argc, char **argv)
+{
+	uint8_t order[PROFILE_COUNT];
+	char row[96];
+
+	profile_sort(order);
+
+	shell_print(sh, PROFILE_HEADER_FMT, PROFILE_HEADER_ARGS);
+
+	for (size_t i = 0; i < PROFILE_COUNT; i++) {
+		if (profile_format_row(&sites[order[i]], row, sizeof(row))) {
+			shell_print(sh, "%s", row);
+		}
+	}
+
+	return 0;
+}
+
+static int cmd_profile_reset(const struct shell *sh, size_t argc, char **argv)
+{
+	profile_reset();
+	shell_print(sh, "Profile cleared");
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_profile,
+	SHELL_CMD(show, NULL, "Show profiled sections, hottest first", cmd_profile_show),
+	SHELL_CMD(reset, NULL, "Clear profile statistics", cmd_profile_reset),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(profile, &sub_profile, "Code-section profiler", NULL);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,71 @@
+/*
+ * Scoped code-section profiler - Header File
+ *
+ * PROFILE_SCOPE(id) timestamps entry and exit of the enclosing block
+ * with the timing API cycle counter and records the duration, minus
+ * the measurement overhead calibrated at boot, for that site.  With
+ * CONFIG_APP_PROFILE disabled the markers compile to nothing.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <zephyr/kernel.h>
+#include <zephyr/timing/timing.h>
+
+/* Profiled code sections: X(id, name).  Add new sites here.
+ * CALIBRATION is the empty scope timed at boot (profile.c).
+ */
+#define PROFILE_SITES(X)					\
+	X(CALIBRATION,     "calibration")			\
+	X(RETAINED_UPDATE, "retained_update")			\
+	X(UTC_GET_US,      "utc_time_get_us")			\
+	X(UTC_FORMAT,      "utc_time_format_us")
+
+enum profile_id {
+#define PROFILE_ENUM(id, name) PROFILE_##id,
+	PROFILE_SITES(PROFILE_ENUM)
+#undef PROFILE_ENUM
+	PROFILE_COUNT
+};
+
+#ifdef CONFIG_APP_PROFILE
+
+struct profile_scope {
+	enum profile_id id;
+	timing_t start;
+};
+
+/* Called automatically when a PROFILE_SCOPE goes out of scope */
+void profile_scope_exit(struct profile_scope *scope);
+
+/**
+ * @brief Profile the rest of the enclosing block as @p site
+ */
+#define PROFILE_SCOPE(site)						\
+	struct profile_scope profile_scope_##site			\
+		__attribute__((cleanup(profile_scope_exit))) = {	\
+			.id = PROFILE_##site,				\
+			.start = timing_counter_get(),			\
+		}
+
+/**
+ * @brief Log all sites, hottest (largest total time) first
+ */
+void profile_dump(void);
+
+/**
+ * @brief Clear the statistics of all sites
+ */
+void profile_reset(void);
+
+#else
+
+#define PROFILE_SCOPE(site)
+
+static inline void profile_dump(void) {}
+static inline void profile_reset(void) {}
+
+#endif /* CONFIG_APP_PROFILE */
+
+#endif /* PROFILE_H */
@@ -5,6 +5,11 @@
  */
 
 #include "retained.h"
+#include "profile.h"
+#include "power_acct.h"
+#include "mono_time.h"
+#include "status.h"
+#include "input_rec.h"
 
 #include <stdint.h>
 #include <string.h>
@@ -17,6 +22,15 @@
 
 #if DT_NODE_HAS_STATUS_OKAY(DT_ALIAS(retainedmemdevice))
 const static struct device *retained_mem_device = DEVICE_DT_GET(DT_ALIAS(retainedmemdevice));
+#define RETAINED_REGION_SIZE DT_REG_SIZE(DT_PARENT(DT_ALIAS(retainedmemdevice)))
+#elif defined(CONFIG_ARCH_POSIX)
+/* native_sim has no retained RAM: emulate the region in process
+ * memory.  It survives the simulated resets of in-process harnesses,
+ * not a restart of the executable.
+ */
+#define RETAINED_REGION_EMULATED
+#define RETAINED_REGION_SIZE 4096
+static uint8_t retained_region[RETAINED_REGION_SIZE];
 #else
 #error "retained_mem region not defined"
 #endif
@@ -26,11 +40,93 @@ struct retained_data retained;
 #define RETAINED_CRC_OFFSET offsetof(struct retained_data, crc)
 #define RETAINED_CHECKED_SIZE (RETAINED_CRC_OFFSET + sizeof(retained.crc))
 
+BUILD_ASSERT(sizeof(struct retained_data) <= RETAINED_DATA_SIZE_MAX,
+	     "retained_data overlaps the retained subsystem windows");
+BUILD_ASSERT(RETAINED_POOL_OFFSET + RETAINED_POOL_SIZE <=
+	     RETAINED_REGION_SIZE,
+	     "retained windows exceed the retained memory region");
+
+static int region_read_raw(size_t offset, void *data, size_t len)
+{
+#ifdef RETAINED_REGION_EMULATED
+	if (offset + len > sizeof(retained_region)) {
+		return -EINVAL;
+	}
+	memcpy(data, &retained_region[offset], len);
+	return 0;
+#else
+	/* Before the driver's POST_KERNEL init (early_init.c) read the
+	 * region as the plain RAM it is.
+	 */
+	if (!device_is_ready(retained_mem_device)) {
+		if (offset + len > RETAINED_REGION_SIZE) {
+			return -EINVAL;
+		}
+		memcpy(data, (const uint8_t *)DT_REG_ADDR(DT_PARENT(DT_ALIAS(retainedmemdevice))) +
+			     offset, len);
+		return 0;
+	}
+
+	return retained_mem_read(retained_mem_device, offset, data, len);
+#endif
+}
+
+static int region_read(size_t offset, void *data, size_t len)
+{
+	int rc = region_read_raw(offset, data, len);
+
+	if (rc == 0) {
+		input_rec_bytes(INPUT_REC_REGION, offset, data, len);
+	}
+
+	return rc;
+}
+
+#ifdef CONFIG_APP_FAULT_INJECT
+/* Bytes left before the simulated reset, negative when disarmed */
+static int32_t fault_budget = -1;
+static size_t fault_written;
+
+size_t retained_fault_arm(int32_t budget)
+{
+	size_t written = fault_written;
+
+	fault_budget = budget;
+	fault_written = 0;
+
+	return written;
+}
+#endif
+
+static int region_write(size_t offset, const void *data, size_t len)
+{
+#ifdef RETAINED_REGION_EMULATED
+	if (offset + len > sizeof(retained_region)) {
+		return -EINVAL;
+	}
+#ifdef CONFIG_APP_FAULT_INJECT
+	if (fault_budget >= 0) {
+		size_t kept = MIN(len, (size_t)fault_budget);
+
+		fault_budget -= kept;
+		len = kept;
+	}
+	fault_written += len;
+#endif
+	memcpy(&retained_region[offset], data, len);
+	return 0;
+#else
+	return retained_mem_write(retained_mem_device, offset, data, len);
+#endif
+}
+
 bool retained_validate(void)
 {
 	int rc;
 
-	rc = retained_mem_read(retained_mem_device, 0, (uint8_t *)&retained, sizeof(retained));
+	input_rec_begin(INPUT_REC_CALL_VALIDATE, 0);
+
+	rc = region_read(0, &retained, sizeof(retained));
 	__ASSERT_NO_MSG(rc == 0);
 
 	/* The residue of a CRC is what you get from the CRC over the
@@ -51,23 +147,72 @@ bool retained_validate(void)
 	/* Reset to accrue runtime from this session. */
 	retained.uptime_latest = 0;
 
-	return valid;
+	return input_rec_end(valid);
 }
 
 void retained_update(void)
 {
+	PROFILE_SCOPE(RETAINED_UPDATE);
 	int rc;
 
-	uint64_t now = k_uptime_ticks();
+	input_rec_begin(INPUT_REC_CALL_UPDATE, 0);
+	input_rec_bytes(INPUT_REC_RETAINED, 0, &retained, sizeof(retained));
+
+	uint64_t now = input_rec_value(INPUT_REC_UPTIME, k_uptime_ticks());
 
 	retained.uptime_sum += (now - retained.uptime_latest);
 	retained.uptime_latest = now;
 
+	power_acct_update();
+	mono_time_update();
+
 	uint32_t crc = crc32_ieee((const uint8_t *)&retained,
 				  RETAINED_CRC_OFFSET);
 
 	retained.crc = sys_cpu_to_le32(crc);
 
-	rc = retained_mem_write(retained_mem_device, 0, (uint8_t *)&retained, sizeof(retained));
+	rc = region_write(0, &retained, sizeof(retained));
 	__ASSERT_NO_MSG(rc == 0);
+	(void)input_rec_end(retained.crc);
+
+	status_publish_retained();
+}
+
+int retained_blob_write(size_t offset, const void *data, size_t len)
+{
+	int rc;
+	uint32_t crc = sys_cpu_to_le32(crc32_ieee(data, len));
+
+	rc = region_write(offset, data, len);
+	if (rc == 0) {
+		rc = region_write(offset + len, &crc, sizeof(crc));
+	}
+
+	return rc;
+}
+
+const uint8_t *retained_region_view(size_t *size)
+{
+	*size = RETAINED_REGION_SIZE;
+#ifdef RETAINED_REGION_EMULATED
+	return retained_region;
+#else
+	return (const uint8_t *)DT_REG_ADDR(DT_PARENT(DT_ALIAS(retainedmemdevice)));
+#endif
+}
+
+int retained_blob_read(size_t offset, void *data, size_t len)
+{
+	int rc;
+	uint32_t crc;
+
+	rc = region_read(offset, data, len);
+	if (rc == 0) {
+		rc = region_read(offset + len, &crc, sizeof(crc));
+	}
+	if (rc != 0) {
+		return rc;
+	}
+
+	return (sys_le32_to_cpu(crc) == crc32_ieee(data, len)) ? 0 : -EBADMSG;
 }
@@ -8,8 +8,31 @@
 #define RETAINED_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/* Layout of the retained memory region.  struct retained_data lives
+ * at offset 0; optional subsystems own the fixed windows below and
+ * store CRC-protected blobs there with retained_blob_write().
+ */
+#define RETAINED_DATA_SIZE_MAX   256
+#define RETAINED_HIST_OFFSET     256
+#define RETAINED_HIST_SIZE       1024
+#define RETAINED_THREAD_STATS_OFFSET 1280
+#define RETAINED_THREAD_STATS_SIZE   256
+#define RETAINED_MONO_TIME_OFFSET    1536
+#define RETAINED_MONO_TIME_SIZE      64
+#define RETAINED_UTC_OFFSET          1600
+#define RETAINED_UTC_SIZE            32
+#define RETAINED_OTA_OFFSET          1632
+#define RETAINED_OTA_SIZE            32
+#define RETAINED_SESSION_OFFSET      1664
+#define RETAINED_SESSION_SIZE        224
+#define RETAINED_WARM_CACHE_OFFSET   1888
+#define RETAINED_WARM_CACHE_SIZE     992
+#define RETAINED_POOL_OFFSET         2880
+#define RETAINED_POOL_SIZE           1216
+
 /* Example of validatable retained data. */
 struct retained_data {
 	/* The uptime from the current session the last time the
@@ -28,6 +51,26 @@ struct retained_data {
 	/* Number of times the application has gone into system off. */
 	uint32_t off_count;
 
+	/* Time-in-state accounting, cumulative over all sessions, in
+	 * microseconds (see power_acct.h).  run + idle + lowpower covers
+	 * the time the application was up; off covers System OFF and
+	 * reset gaps measured with the GRTC.
+	 */
+	uint64_t run_us;
+	uint64_t idle_us;
+	uint64_t lowpower_us;
+	uint64_t off_us;
+
+	/* GRTC value when System OFF or a reset was entered, 0 if the
+	 * previous session did not end through power_acct_enter_off().
+	 */
+	uint64_t off_entry_grtc;
+
+	/* GRTC value System OFF was programmed to wake at, 0 if the
+	 * previous session did not end through sysoff_enter().
+	 */
+	uint64_t wake_target_grtc;
+
 	/* CRC used to validate the retained data.  This must be
 	 * stored little-endian, and covers everything up to but not
 	 * including this field.
@@ -52,4 +95,37 @@ bool retained_validate(void);
  */
 void retained_update(void);
 
+/* Store a blob followed by its CRC-32 in the retained region.
+ *
+ * @return 0 on success, negative errno from the retained_mem driver
+ * otherwise.
+ */
+int retained_blob_write(size_t offset, const void *data, size_t len);
+
+/* Load a blob stored with retained_blob_write().
+ *
+ * @return 0 if the blob was read and its CRC matched, -EBADMSG if the
+ * CRC did not match, other negative errno on driver errors.
+ */
+int retained_blob_read(size_t offset, void *data, size_t len);
+
+/* Read-only view of the whole retained region, for zero-copy readers
+ * such as the SMP retained group.  Concurrent updates are not locked
+ * out; blobs carry their own CRC.
+ *
+ * @param size Set to the size of the region in bytes.
+ */
+const uint8_t *retained_region_view(size_t *size);
+
+#ifdef CONFIG_APP_FAULT_INJECT
+/* Fault injection on the emulated region (fault_inject.c): once
+ * @p budget more bytes have been written, the rest of every write is
+ * dropped, as if the device reset in the middle of it.  A negative
+ * budget disarms.
+ *
+ * @return Bytes written to the region since the previous call.
+ */
+size_t retained_fault_arm(int32_t budget);
+#endif
+
 #endif /* RETAINED_H_ */
@@ -0,0 +1,114 @@
+/*
+ * Session history
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include "session_hist.h"
+#include "retained.h"
+
+LOG_MODULE_REGISTER(session_hist, LOG_LEVEL_INF);
+
+#define SESSION_HIST_LEN						\
+	((RETAINED_SESSION_SIZE - 2 * sizeof(uint32_t)) / sizeof(struct session_entry))
+
+struct session_ring {
+	uint16_t next;           /* slot the next entry goes to */
+	uint16_t count;
+	struct session_entry entries[SESSION_HIST_LEN];
+};
+
+BUILD_ASSERT(sizeof(struct session_ring) + sizeof(uint32_t) <= RETAINED_SESSION_SIZE,
+	     "session ring does not fit its retained window");
+
+static const char *const kind_names[] = {
+	[SESSION_BOOT] = "boot",
+	[SESSION_OTA] = "update",
+	[SESSION_OTA_NOT_APPLIED] = "not applied",
+	[SESSION_IMAGE_CHANGED] = "image changed",
+};
+
+static void load(struct session_ring *ring)
+{
+	if (retained_blob_read(RETAINED_SESSION_OFFSET, ring, sizeof(*ring)) != 0 ||
+	    ring->next >= SESSION_HIST_LEN || ring->count > SESSION_HIST_LEN) {
+		memset(ring, 0, sizeof(*ring));
+	}
+}
+
+static void store(const struct session_ring *ring)
+{
+	(void)retained_blob_write(RETAINED_SESSION_OFFSET, ring, sizeof(*ring));
+}
+
+static uint16_t slot(const struct session_ring *ring, uint32_t age)
+{
+	return (ring->next + SESSION_HIST_LEN - 1U - age) % SESSION_HIST_LEN;
+}
+
+void session_hist_record(const struct session_entry *entry)
+{
+	struct session_ring ring;
+
+	load(&ring);
+	ring.entries[ring.next] = *entry;
+	ring.next = (ring.next + 1U) % SESSION_HIST_LEN;
+	ring.count = MIN(ring.count + 1U, SESSION_HIST_LEN);
+	store(&ring);
+}
+
+bool session_hist_get(uint32_t age, struct session_entry *entry)
+{
+	struct session_ring ring;
+
+	load(&ring);
+	if (age >= ring.count) {
+		return false;
+	}
+
+	*entry = ring.entries[slot(&ring, age)];
+	return true;
+}
+
+void session_hist_amend(const struct session_entry *entry)
+{
+	struct session_ring ring;
+
+	load(&ring);
+	if (ring.count == 0U) {
+		return;
+	}
+
+	ring.entries[slot(&ring, 0)] = *entry;
+	store(&ring);
+}
+
+void session_hist_print(void)
+{
+	struct session_ring ring;
+
+	load(&ring);
+	LOG_INF("Session history: %u of %u entries", ring.count, SESSION_HIST_LEN);
+
+	for (uint32_t age = 0; age < ring.count; age++) {
+		const struct session_entry *e = &ring.entries[slot(&ring, age)];
+		const char *kind = (e->kind < ARRAY_SIZE(kind_names)) ? kind_names[e->kind] : "?";
+
+		if (e->kind == SESSION_BOOT) {
+			LOG_INF("  boot %u: %u.%u.%u", e->boots, e->version >> 24,
+				(e->version >> 16) & 0xffU, e->version & 0xffffU);
+		} else if (e->downtime_ms == SESSION_DOWNTIME_UNKNOWN) {
+			LOG_INF("  boot %u: %u.%u.%u <- %u.%u.%u %s, downtime unknown",
+				e->boots, e->version >> 24, (e->version >> 16) & 0xffU,
+				e->version & 0xffffU, e->from_version >> 24,
+				(e->from_version >> 16) & 0xffU, e->from_version & 0xffffU, kind);
+		} else {
+			LOG_INF("  boot %u: %u.%u.%u <- %u.%u.%u %s, downtime %u ms",
+				e->boots, e->version >> 24, (e->version >> 16) & 0xffU,
+				e->version & 0xffffU, e->from_version >> 24,
+				(e->from_version >> 16) & 0xffU, e->from_version & 0xffffU, kind,
+				e->downtime_ms);
+		}
+	}
+}
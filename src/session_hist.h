@@ -0,0 +1,69 @@
+/*
+ * Session history - Header File
+ *
+ * A ring of the last boots in the retained region (window
+ * RETAINED_SESSION_OFFSET), one entry per session: the boot count,
+ * the running image version and, for a boot into a new image, the
+ * version it replaced and the downtime of the update.  The ring is
+ * one CRC-protected blob, readable over SMP as section "sessions".
+ */
+
+#ifndef SESSION_HIST_H
+#define SESSION_HIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SESSION_DOWNTIME_UNKNOWN UINT32_MAX
+
+/* major.minor.revision as 8.8.16 bits */
+#define SESSION_VERSION(major, minor, revision)				\
+	(((uint32_t)(major) << 24) | ((uint32_t)(minor) << 16) | (uint16_t)(revision))
+
+enum session_kind {
+	SESSION_BOOT,            /* same image as the previous session */
+	SESSION_OTA,             /* the requested update is running */
+	SESSION_OTA_NOT_APPLIED, /* update requested, old image still runs */
+	SESSION_IMAGE_CHANGED,   /* other image without a request (revert) */
+};
+
+struct session_entry {
+	uint32_t boots;          /* retained.boots at boot */
+	uint32_t version;        /* SESSION_VERSION() of the running image */
+	uint32_t from_version;   /* image before an update, else 0 */
+	uint32_t downtime_ms;    /* request to app start, or _UNKNOWN */
+	uint8_t kind;            /* enum session_kind */
+	uint8_t reserved[3];
+};
+
+#ifdef CONFIG_APP_SESSION_HIST
+
+/**
+ * @brief Append an entry, dropping the oldest one if the ring is full
+ *
+ * A ring that fails its CRC starts over empty.
+ */
+void session_hist_record(const struct session_entry *entry);
+
+/**
+ * @brief Get an entry
+ *
+ * @param age 0 for the newest entry, 1 for the one before, ...
+ * @param entry Filled with the entry
+ * @return true if there is an entry that old
+ */
+bool session_hist_get(uint32_t age, struct session_entry *entry);
+
+/**
+ * @brief Replace the newest entry, e.g. once its downtime is known
+ */
+void session_hist_amend(const struct session_entry *entry);
+
+/**
+ * @brief Log the ring, newest first
+ */
+void session_hist_print(void);
+
+#endif /* CONFIG_APP_SESSION_HIST */
+
+#endif /* SESSION_HIST_H */
@@ -0,0 +1,201 @@
+/*
+ * MCUmgr SMP group for retained data and trace retrieval
+ *
+ * Group MGMT_GROUP_ID_PERUSER (64):
+ *
+ *  - list (id 0, read): { "sections": [ { "name", "size" [, "esz", "head"] } ] }
+ *  - read (id 1, read): request { "sec": name, "off": offset },
+ *    response { "off", "len": section size, "data": chunk }
+ *
+ * Chunks are encoded straight from the retained region (or the trace
+ * ring, or the input recording "rec") without an intermediate copy.
+ * scripts/smp_retained.py pulls whole sections and reports the
+ * throughput.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/mgmt/mcumgr/mgmt/mgmt.h>
+#include <zephyr/mgmt/mcumgr/mgmt/handlers.h>
+#include <zephyr/mgmt/mcumgr/smp/smp.h>
+#include <zephyr/mgmt/mcumgr/util/zcbor_bulk.h>
+#include <string.h>
+#include <zcbor_common.h>
+#include <zcbor_decode.h>
+#include <zcbor_encode.h>
+#include "retained.h"
+#include "func_trace.h"
+#include "input_rec.h"
+
+#define RETAINED_MGMT_ID_LIST 0
+#define RETAINED_MGMT_ID_READ 1
+
+struct retained_section {
+	const char *name;
+	size_t offset;
+	size_t size;
+};
+
+/* Windows of the retained region, see retained.h; "region" is all of it */
+static const struct retained_section sections[] = {
+	{ "data", 0, sizeof(struct retained_data) },
+	{ "hist", RETAINED_HIST_OFFSET, RETAINED_HIST_SIZE },
+	{ "thread_stats", RETAINED_THREAD_STATS_OFFSET, RETAINED_THREAD_STATS_SIZE },
+	{ "mono_time", RETAINED_MONO_TIME_OFFSET, RETAINED_MONO_TIME_SIZE },
+	{ "utc", RETAINED_UTC_OFFSET, RETAINED_UTC_SIZE },
+	{ "ota", RETAINED_OTA_OFFSET, RETAINED_OTA_SIZE },
+	{ "sessions", RETAINED_SESSION_OFFSET, RETAINED_SESSION_SIZE },
+	{ "warm_cache", RETAINED_WARM_CACHE_OFFSET, RETAINED_WARM_CACHE_SIZE },
+	{ "pool", RETAINED_POOL_OFFSET, RETAINED_POOL_SIZE },
+	{ "region", 0, 0 },
+};
+
+/* Resolve a section name to its bytes; false if unknown */
+static bool section_get(const struct zcbor_string *name, const uint8_t **data, size_t *size)
+{
+	size_t region_size;
+	const uint8_t *region = retained_region_view(&region_size);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sections); i++) {
+		if (strlen(sections[i].name) == name->len &&
+		    memcmp(sections[i].name, name->value, name->len) == 0) {
+			*data = region + sections[i].offset;
+			*size = (sections[i].size != 0U) ? sections[i].size : region_size;
+			return true;
+		}
+	}
+
+#ifdef CONFIG_APP_FUNC_TRACE
+	if (name->len == 5 && memcmp(name->value, "trace", 5) == 0) {
+		size_t count, event_size;
+		uint32_t recorded;
+
+		*data = func_trace_ring(&count, &event_size, &recorded);
+		*size = count * event_size;
+		return *data != NULL;
+	}
+#endif
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	if (name->len == 3 && memcmp(name->value, "rec", 3) == 0) {
+		*data = input_rec_stream(size);
+		return true;
+	}
+#endif
+
+	return false;
+}
+
+static int retained_mgmt_list(struct smp_streamer *ctxt)
+{
+	zcbor_state_t *zse = ctxt->writer->zs;
+	size_t region_size;
+	bool ok;
+
+	(void)retained_region_view(&region_size);
+
+	ok = zcbor_tstr_put_lit(zse, "sections") &&
+	     zcbor_list_start_encode(zse, ARRAY_SIZE(sections) + 2);
+
+	for (size_t i = 0; ok && i < ARRAY_SIZE(sections); i++) {
+		size_t size = (sections[i].size != 0U) ? sections[i].size : region_size;
+
+		ok = zcbor_map_start_encode(zse, 2) &&
+		     zcbor_tstr_put_lit(zse, "name") &&
+		     zcbor_tstr_put_term(zse, sections[i].name, CONFIG_ZCBOR_MAX_STR_LEN) &&
+		     zcbor_tstr_put_lit(zse, "size") &&
+		     zcbor_uint32_put(zse, (uint32_t)size) &&
+		     zcbor_map_end_encode(zse, 2);
+	}
+
+#ifdef CONFIG_APP_FUNC_TRACE
+	size_t count, event_size;
+	uint32_t recorded;
+
+	if (ok && func_trace_ring(&count, &event_size, &recorded) != NULL) {
+		ok = zcbor_map_start_encode(zse, 4) &&
+		     zcbor_tstr_put_lit(zse, "name") &&
+		     zcbor_tstr_put_lit(zse, "trace") &&
+		     zcbor_tstr_put_lit(zse, "size") &&
+		     zcbor_uint32_put(zse, (uint32_t)(count * event_size)) &&
+		     zcbor_tstr_put_lit(zse, "esz") &&
+		     zcbor_uint32_put(zse, (uint32_t)event_size) &&
+		     zcbor_tstr_put_lit(zse, "head") &&
+		     zcbor_uint32_put(zse, recorded) &&
+		     zcbor_map_end_encode(zse, 4);
+	}
+#endif
+
+#ifdef CONFIG_APP_INPUT_REC_RECORD
+	size_t rec_size;
+
+	(void)input_rec_stream(&rec_size);
+	ok = ok && zcbor_map_start_encode(zse, 2) &&
+	     zcbor_tstr_put_lit(zse, "name") &&
+	     zcbor_tstr_put_lit(zse, "rec") &&
+	     zcbor_tstr_put_lit(zse, "size") &&
+	     zcbor_uint32_put(zse, (uint32_t)rec_size) &&
+	     zcbor_map_end_encode(zse, 2);
+#endif
+
+	ok = ok && zcbor_list_end_encode(zse, ARRAY_SIZE(sections) + 2);
+
+	return ok ? MGMT_ERR_EOK : MGMT_ERR_EMSGSIZE;
+}
+
+static int retained_mgmt_read(struct smp_streamer *ctxt)
+{
+	zcbor_state_t *zse = ctxt->writer->zs;
+	zcbor_state_t *zsd = ctxt->reader->zs;
+	struct zcbor_string name = { 0 };
+	uint32_t off = 0;
+	size_t decoded;
+	const uint8_t *data;
+	size_t size, len;
+	bool ok;
+
+	struct zcbor_map_decode_key_val keys[] = {
+		ZCBOR_MAP_DECODE_KEY_DECODER("sec", zcbor_tstr_decode, &name),
+		ZCBOR_MAP_DECODE_KEY_DECODER("off", zcbor_uint32_decode, &off),
+	};
+
+	if (zcbor_map_decode_bulk(zsd, keys, ARRAY_SIZE(keys), &decoded) != 0 ||
+	    name.len == 0U) {
+		return MGMT_ERR_EINVAL;
+	}
+
+	if (!section_get(&name, &data, &size)) {
+		return MGMT_ERR_ENOENT;
+	}
+	if (off > size) {
+		return MGMT_ERR_EINVAL;
+	}
+
+	len = MIN(size - off, CONFIG_APP_SMP_RETAINED_CHUNK);
+
+	ok = zcbor_tstr_put_lit(zse, "off") &&
+	     zcbor_uint32_put(zse, off) &&
+	     zcbor_tstr_put_lit(zse, "len") &&
+	     zcbor_uint32_put(zse, (uint32_t)size) &&
+	     zcbor_tstr_put_lit(zse, "data") &&
+	     zcbor_bstr_encode_ptr(zse, (const char *)data + off, len);
+
+	return ok ? MGMT_ERR_EOK : MGMT_ERR_EMSGSIZE;
+}
+
+static const struct mgmt_handler retained_mgmt_handlers[] = {
+	[RETAINED_MGMT_ID_LIST] = { .mh_read = retained_mgmt_list },
+	[RETAINED_MGMT_ID_READ] = { .mh_read = retained_mgmt_read },
+};
+
+static struct mgmt_group retained_mgmt_group = {
+	.mg_handlers = retained_mgmt_handlers,
+	.mg_handlers_count = ARRAY_SIZE(retained_mgmt_handlers),
+	.mg_group_id = MGMT_GROUP_ID_PERUSER,
+};
+
+static void retained_mgmt_register(void)
+{
+	mgmt_register_group(&retained_mgmt_group);
+}
+
+MCUMGR_HANDLER_DEFINE(retained_mgmt, retained_mgmt_register);
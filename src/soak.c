@@ -0,0 +1,320 @@
+/*
+ * Accelerated-time soak test
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <stdlib.h>
+#include <string.h>
+#include "soak.h"
+#include "grtc.h"
+#include "retained.h"
+#include "utc_time.h"
+
+LOG_MODULE_REGISTER(soak, LOG_LEVEL_INF);
+
+/* Every checkpoint and clock change would otherwise be logged */
+ZBUS_OBS_DECLARE(status_logger);
+
+#define SOAK_STEP_S      60U
+#define SOAK_HOUR_S      3600U
+#define SOAK_DAY_S       86400U
+
+/* 2025-01-01T00:00:00Z, midnight, so the uptime gives the time of day */
+#define SOAK_EPOCH_US    1735689600000000ULL
+
+/* Tuning-fork crystal: -0.034 ppm / degC^2 around the turnover */
+#define XTAL_TURNOVER_MC 25000
+#define XTAL_PARABOLA    34
+
+/* A soft reset must keep UTC to within one step of clock drift */
+#define UTC_CONTINUITY_US 1000
+
+enum reset_kind {
+	RESET_SOFT,      /* GRTC and retained RAM kept */
+	RESET_WATCHDOG,  /* GRTC restarts, retained RAM kept */
+	RESET_POWER_ON,  /* GRTC restarts, retained RAM lost */
+	RESET_KINDS,
+};
+
+static const char *const reset_names[RESET_KINDS] = {
+	"soft", "watchdog", "power-on",
+};
+
+struct err_stats {
+	uint64_t abs_sum_us;
+	uint64_t abs_max_us;
+	uint32_t samples;
+	uint32_t unsynced_min;
+};
+
+static struct {
+	uint32_t resets[RESET_KINDS];
+	uint32_t syncs;
+	uint32_t dropped;
+	uint32_t outage_skipped;
+	uint32_t survived;   /* retained data intact after soft/watchdog */
+	uint32_t lost;       /* retained data gone after soft/watchdog */
+	uint32_t corrupt;    /* validated with the wrong contents */
+	uint32_t wiped;      /* power-on garbage correctly rejected */
+	uint32_t utc_kept;   /* calibration carried across a soft reset */
+	uint32_t utc_bad;    /* UTC restored when it must not be, or lost */
+	uint64_t holdover_max_us;
+} stats;
+
+static struct err_stats window;
+static struct err_stats total;
+
+/* boots as of the last retained_update() */
+static uint32_t committed_boots;
+
+static uint64_t start_us;
+
+static uint32_t xorshift_state = CONFIG_APP_SOAK_SEED;
+
+static uint32_t soak_rand(void)
+{
+	xorshift_state ^= xorshift_state << 13;
+	xorshift_state ^= xorshift_state >> 17;
+	xorshift_state ^= xorshift_state << 5;
+	return xorshift_state;
+}
+
+static uint64_t true_utc_us(void)
+{
+	return SOAK_EPOCH_US + k_ticks_to_us_floor64(k_uptime_ticks()) - start_us;
+}
+
+/* Triangle profile: coldest at 04:00, warmest at 16:00 */
+static int32_t temperature_mc(uint32_t second_of_day)
+{
+	const int32_t swing = CONFIG_APP_SOAK_TEMP_SWING_C * 1000;
+	const int32_t low = CONFIG_APP_SOAK_TEMP_MEAN_C * 1000 - swing / 2;
+	uint32_t phase = (second_of_day + SOAK_DAY_S - 4U * SOAK_HOUR_S) % SOAK_DAY_S;
+	uint32_t half = SOAK_DAY_S / 2U;
+
+	if (phase >= half) {
+		phase = SOAK_DAY_S - phase;
+	}
+
+	return low + (int32_t)((int64_t)swing * phase / half);
+}
+
+static int32_t xtal_error_ppb(int32_t temp_mc)
+{
+	int64_t d = temp_mc - XTAL_TURNOVER_MC;
+
+	return CONFIG_APP_SOAK_PPM * 1000 - (int32_t)(XTAL_PARABOLA * d * d / 1000000);
+}
+
+static int64_t utc_error_us(void)
+{
+	return (int64_t)(utc_time_get_us() - true_utc_us());
+}
+
+static void record(struct err_stats *s, uint64_t abs_err_us, bool synced)
+{
+	if (!synced) {
+		s->unsynced_min += SOAK_STEP_S / 60U;
+		return;
+	}
+	s->abs_sum_us += abs_err_us;
+	s->abs_max_us = MAX(s->abs_max_us, abs_err_us);
+	s->samples++;
+}
+
+static void boot_commit(void)
+{
+	retained.boots++;
+	retained_update();
+	committed_boots = retained.boots;
+}
+
+static void emulate_reset(enum reset_kind kind)
+{
+	bool was_calibrated = utc_time_is_calibrated();
+	int64_t err_before = was_calibrated ? utc_error_us() : 0;
+	bool valid;
+	int err;
+
+	stats.resets[kind]++;
+
+	if (kind != RESET_SOFT) {
+		grtc_sim_restart();
+	}
+	if (kind == RESET_POWER_ON) {
+		size_t size;
+		uint8_t *region = (uint8_t *)retained_region_view(&size);
+
+		/* RAM powers up with arbitrary contents */
+		for (size_t i = 0; i < size; i++) {
+			region[i] = (uint8_t)soak_rand();
+		}
+	}
+
+	/* What the boot path does: the RAM copy is gone */
+	memset(&retained, 0xa5, sizeof(retained));
+	valid = retained_validate();
+	/* The new session starts now, not at kernel uptime 0 */
+	retained.uptime_latest = k_uptime_ticks();
+
+	if (kind == RESET_POWER_ON) {
+		if (valid) {
+			stats.corrupt++;
+		} else {
+			stats.wiped++;
+		}
+	} else if (!valid) {
+		stats.lost++;
+	} else if (retained.boots != committed_boots) {
+		stats.corrupt++;
+	} else {
+		stats.survived++;
+	}
+
+	err = utc_time_restore();
+	utc_time_publish();
+
+	if (kind == RESET_SOFT && was_calibrated) {
+		if (err == 0 && llabs(utc_error_us() - err_before) <= UTC_CONTINUITY_US) {
+			stats.utc_kept++;
+		} else {
+			stats.utc_bad++;
+		}
+	} else if (err == 0) {
+		/* Nothing valid to restore, yet a calibration came back */
+		stats.utc_bad++;
+	}
+
+	boot_commit();
+}
+
+static enum reset_kind pick_reset(void)
+{
+	uint32_t r = soak_rand() % 100U;
+
+	return (r < 70U) ? RESET_SOFT : (r < 90U) ? RESET_WATCHDOG : RESET_POWER_ON;
+}
+
+/* Uniform over (0, 2 * mean], in steps */
+static uint32_t next_reset_in(void)
+{
+	uint32_t span = 2U * CONFIG_APP_SOAK_RESET_INTERVAL_H * (SOAK_HOUR_S / SOAK_STEP_S);
+
+	return 1U + soak_rand() % MAX(span, 1U);
+}
+
+static void report(uint32_t elapsed_s, int32_t temp_mc, int32_t ppb)
+{
+	uint32_t samples = MAX(window.samples, 1U);
+
+	LOG_INF("Soak day %u %02u:00  %3d C %6d ppb  UTC error max %llu mean %llu us, "
+		"unsynced %u min",
+		elapsed_s / SOAK_DAY_S, (elapsed_s % SOAK_DAY_S) / SOAK_HOUR_S,
+		temp_mc / 1000, ppb,
+		window.abs_max_us, window.abs_sum_us / samples, window.unsynced_min);
+	memset(&window, 0, sizeof(window));
+}
+
+int soak_run(void)
+{
+	const uint32_t steps = CONFIG_APP_SOAK_DAYS * (SOAK_DAY_S / SOAK_STEP_S);
+	const uint32_t sync_steps = MAX(CONFIG_APP_SOAK_SYNC_INTERVAL_S / SOAK_STEP_S, 1U);
+	const uint32_t checkpoint_steps = SOAK_HOUR_S / SOAK_STEP_S;
+	const uint32_t report_steps = CONFIG_APP_SOAK_REPORT_H * (SOAK_HOUR_S / SOAK_STEP_S);
+	const uint32_t outage_steps = CONFIG_APP_SOAK_OUTAGE_H * (SOAK_HOUR_S / SOAK_STEP_S);
+	const uint32_t outage_start = (steps > outage_steps) ? (steps - outage_steps) / 2U : 0U;
+	uint32_t reset_at = next_reset_in();
+	int32_t temp_mc = 0;
+	int32_t ppb = 0;
+
+	LOG_INF("=== Soak: %u days, %d ppm, %d +/- %d C, sync every %u s (%u%% dropped), "
+		"%u h outage, reset every %u h ===",
+		CONFIG_APP_SOAK_DAYS, CONFIG_APP_SOAK_PPM, CONFIG_APP_SOAK_TEMP_MEAN_C,
+		CONFIG_APP_SOAK_TEMP_SWING_C / 2, CONFIG_APP_SOAK_SYNC_INTERVAL_S,
+		CONFIG_APP_SOAK_DROPOUT_PCT, CONFIG_APP_SOAK_OUTAGE_H,
+		CONFIG_APP_SOAK_RESET_INTERVAL_H);
+
+	(void)zbus_obs_set_enable(&status_logger, false);
+	memset(&stats, 0, sizeof(stats));
+	memset(&window, 0, sizeof(window));
+	memset(&total, 0, sizeof(total));
+
+	start_us = k_ticks_to_us_floor64(k_uptime_ticks());
+	utc_time_calibrate(true_utc_us());
+	boot_commit();
+
+	for (uint32_t step = 1; step <= steps; step++) {
+		bool outage = (step >= outage_start && step < outage_start + outage_steps);
+
+		temp_mc = temperature_mc((step * SOAK_STEP_S) % SOAK_DAY_S);
+		ppb = xtal_error_ppb(temp_mc);
+		grtc_sim_set_ppb(ppb);
+
+		k_sleep(K_SECONDS(SOAK_STEP_S));
+
+		if (step % sync_steps == 0U) {
+			if (outage) {
+				stats.outage_skipped++;
+			} else if (soak_rand() % 100U < CONFIG_APP_SOAK_DROPOUT_PCT) {
+				stats.dropped++;
+			} else {
+				utc_time_calibrate(true_utc_us());
+				stats.syncs++;
+			}
+		}
+
+		if (step % checkpoint_steps == 0U) {
+			retained_update();
+			committed_boots = retained.boots;
+		}
+
+		/* Last, so that a sync never lands on a just-restarted GRTC */
+		if (--reset_at == 0U) {
+			emulate_reset(pick_reset());
+			reset_at = next_reset_in();
+		}
+
+		bool synced = utc_time_is_calibrated();
+		int64_t err = synced ? utc_error_us() : 0;
+		uint64_t abs_err = (uint64_t)llabs(err);
+
+		record(&window, abs_err, synced);
+		record(&total, abs_err, synced);
+		if (outage && synced) {
+			stats.holdover_max_us = MAX(stats.holdover_max_us, abs_err);
+		}
+
+		if (step % report_steps == 0U) {
+			report(step * SOAK_STEP_S, temp_mc, ppb);
+		}
+	}
+
+	(void)zbus_obs_set_enable(&status_logger, true);
+
+	LOG_INF("Soak: %u days simulated, %u steps of %u s", CONFIG_APP_SOAK_DAYS,
+		steps, SOAK_STEP_S);
+	LOG_INF("Soak: UTC error max %llu mean %llu us, %u h holdover max %llu us, "
+		"unsynced %u min",
+		total.abs_max_us, total.abs_sum_us / MAX(total.samples, 1U),
+		CONFIG_APP_SOAK_OUTAGE_H, stats.holdover_max_us, total.unsynced_min);
+	LOG_INF("Soak: syncs %u, dropped %u, skipped in outage %u",
+		stats.syncs, stats.dropped, stats.outage_skipped);
+	LOG_INF("Soak: resets %s %u, %s %u, %s %u",
+		reset_names[RESET_SOFT], stats.resets[RESET_SOFT],
+		reset_names[RESET_WATCHDOG], stats.resets[RESET_WATCHDOG],
+		reset_names[RESET_POWER_ON], stats.resets[RESET_POWER_ON]);
+	LOG_INF("Soak: retained survived %u, lost %u, corrupt %u, power-on wiped %u; "
+		"UTC kept %u, wrong %u",
+		stats.survived, stats.lost, stats.corrupt, stats.wiped,
+		stats.utc_kept, stats.utc_bad);
+
+	if (stats.lost != 0U || stats.corrupt != 0U || stats.utc_bad != 0U) {
+		LOG_ERR("Soak: FAIL");
+		return -EIO;
+	}
+
+	LOG_INF("Soak: PASS");
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * Accelerated-time soak test - Header File
+ *
+ * Runs CONFIG_APP_SOAK_DAYS of simulated operation on native_sim or
+ * nrf54l15bsim, where time is simulated and a day of sleeping takes
+ * a fraction of a second.  The kernel uptime is the true time; the
+ * application sees a simulated GRTC (grtc_sim.c) whose frequency
+ * error follows a crystal's temperature curve over a daily
+ * temperature profile.  Along the way:
+ *
+ * - UTC syncs every CONFIG_APP_SOAK_SYNC_INTERVAL_S, randomly dropped,
+ *   plus one long outage in the middle of the run (holdover)
+ * - hourly retained_update() checkpoints
+ * - in-process resets: soft (GRTC and retained RAM kept), watchdog
+ *   (GRTC restarts) and power-on (GRTC restarts, retained RAM lost),
+ *   each followed by the boot path's retained_validate() and
+ *   utc_time_restore()
+ *
+ * UTC error statistics are logged every CONFIG_APP_SOAK_REPORT_H and
+ * for the whole run, followed by the retained-data integrity over all
+ * resets and "Soak: PASS" or "Soak: FAIL".
+ */
+
+#ifndef SOAK_H
+#define SOAK_H
+
+#ifdef CONFIG_APP_SOAK
+
+/**
+ * @brief Run the soak test and log the results
+ *
+ * @return 0 if the retained data survived every reset it should have
+ * survived, -EIO otherwise
+ */
+int soak_run(void);
+
+#else
+
+static inline int soak_run(void) { return 0; }
+
+#endif /* CONFIG_APP_SOAK */
+
+#endif /* SOAK_H */
@@ -0,0 +1,118 @@
+/*
+ * Event-driven status publication
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include <string.h>
+#include "status.h"
+#include "retained.h"
+#include "grtc.h"
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(status, LOG_LEVEL_INF);
+
+static void status_log_cb(const struct zbus_channel *chan);
+
+ZBUS_LISTENER_DEFINE(status_logger, status_log_cb);
+
+ZBUS_CHAN_DEFINE(clock_state_chan, struct clock_state_msg, NULL, NULL,
+		 ZBUS_OBSERVERS(status_logger), ZBUS_MSG_INIT(0));
+
+ZBUS_CHAN_DEFINE(retained_stats_chan, struct retained_stats_msg, NULL, NULL,
+		 ZBUS_OBSERVERS(status_logger), ZBUS_MSG_INIT(0));
+
+ZBUS_CHAN_DEFINE(reset_event_chan, struct reset_event_msg, NULL, NULL,
+		 ZBUS_OBSERVERS(status_logger), ZBUS_MSG_INIT(0));
+
+static void status_log_cb(const struct zbus_channel *chan)
+{
+	if (chan == &clock_state_chan) {
+		const struct clock_state_msg *msg = zbus_chan_const_msg(chan);
+
+		LOG_INF("Clock: %s, offset %lld us (GRTC %llu us)",
+			msg->calibrated ? "calibrated" : "uncalibrated",
+			msg->utc_offset_us, msg->grtc_us);
+	} else if (chan == &retained_stats_chan) {
+		const struct retained_stats_msg *msg = zbus_chan_const_msg(chan);
+
+		LOG_INF("Retained: boots=%u, off_count=%u, uptime_sum=%llu ticks (%.3f sec)",
+			msg->boots, msg->off_count, msg->uptime_sum,
+			(double)msg->uptime_sum / CONFIG_SYS_CLOCK_TICKS_PER_SEC);
+	} else if (chan == &reset_event_chan) {
+		const struct reset_event_msg *msg = zbus_chan_const_msg(chan);
+
+		LOG_INF("Reset event: %s, boots=%u, GRTC %llu us, retained %s",
+			msg->type == RESET_EVENT_BOOT ? "boot" : "reset requested",
+			msg->boots, msg->grtc_us,
+			msg->retained_valid ? "valid" : "invalid");
+	}
+}
+
+void status_publish_clock(bool calibrated, int64_t utc_offset_us)
+{
+	struct clock_state_msg msg;
+
+	(void)zbus_chan_read(&clock_state_chan, &msg, K_NO_WAIT);
+	if (msg.calibrated == calibrated && msg.utc_offset_us == utc_offset_us) {
+		return;
+	}
+
+	msg.calibrated = calibrated;
+	msg.utc_offset_us = utc_offset_us;
+	msg.grtc_us = grtc_read_us();
+	(void)zbus_chan_pub(&clock_state_chan, &msg, K_NO_WAIT);
+}
+
+void status_publish_retained(void)
+{
+	struct retained_stats_msg last;
+	struct retained_stats_msg msg = {
+		.boots = retained.boots,
+		.off_count = retained.off_count,
+		.uptime_sum = retained.uptime_sum,
+	};
+
+	(void)zbus_chan_read(&retained_stats_chan, &last, K_NO_WAIT);
+	if (memcmp(&last, &msg, sizeof(msg)) == 0) {
+		return;
+	}
+
+	(void)zbus_chan_pub(&retained_stats_chan, &msg, K_NO_WAIT);
+}
+
+void status_publish_reset(enum reset_event_type type, bool retained_valid)
+{
+	struct reset_event_msg msg = {
+		.type = type,
+		.boots = retained.boots,
+		.grtc_us = grtc_read_us(),
+		.retained_valid = retained_valid,
+	};
+
+	(void)zbus_chan_pub(&reset_event_chan, &msg, K_NO_WAIT);
+}
+
+#ifdef CONFIG_SHELL
+static int cmd_status(const struct shell *sh, size_t argc, char **argv)
+{
+	struct clock_state_msg clock;
+	struct retained_stats_msg stats;
+
+	(void)zbus_chan_read(&clock_state_chan, &clock, K_NO_WAIT);
+	(void)zbus_chan_read(&retained_stats_chan, &stats, K_NO_WAIT);
+
+	shell_print(sh, "Clock:    %s, offset %lld us",
+		    clock.calibrated ? "calibrated" : "uncalibrated", clock.utc_offset_us);
+	shell_print(sh, "Retained: boots=%u, off_count=%u, uptime_sum=%llu ticks",
+		    stats.boots, stats.off_count, stats.uptime_sum);
+	shell_print(sh, "GRTC:     %llu us", grtc_read_us());
+	return 0;
+}
+
+SHELL_CMD_REGISTER(status, NULL, "Show the last published status", cmd_status);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,61 @@
+/*
+ * Event-driven status publication - Header File
+ *
+ * Clock state, retained statistics and reset events are published on
+ * zbus channels only when they change.  The logger is attached
+ * statically; telemetry or other consumers can add observers at run
+ * time with zbus_chan_add_obs().
+ */
+
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <zephyr/zbus/zbus.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Published on clock_state_chan */
+struct clock_state_msg {
+	bool calibrated;
+	int64_t utc_offset_us;  /**< UTC - GRTC */
+	uint64_t grtc_us;       /**< GRTC at the change */
+};
+
+/** Published on retained_stats_chan */
+struct retained_stats_msg {
+	uint32_t boots;
+	uint32_t off_count;
+	uint64_t uptime_sum;    /**< Kernel ticks */
+};
+
+enum reset_event_type {
+	RESET_EVENT_BOOT,       /**< Application started */
+	RESET_EVENT_REQUESTED,  /**< Software reset about to happen */
+};
+
+/** Published on reset_event_chan */
+struct reset_event_msg {
+	enum reset_event_type type;
+	uint32_t boots;
+	uint64_t grtc_us;
+	bool retained_valid;
+};
+
+ZBUS_CHAN_DECLARE(clock_state_chan, retained_stats_chan, reset_event_chan);
+
+/**
+ * @brief Publish the clock state if it changed
+ */
+void status_publish_clock(bool calibrated, int64_t utc_offset_us);
+
+/**
+ * @brief Publish the retained statistics if they changed
+ */
+void status_publish_retained(void);
+
+/**
+ * @brief Publish a reset event
+ */
+void status_publish_reset(enum reset_event_type type, bool retained_valid);
+
+#endif /* STATUS_H */
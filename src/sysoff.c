@@ -0,0 +1,82 @@
+/*
+ * System OFF with GRTC wake-up
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/poweroff.h>
+#include <zephyr/drivers/timer/nrf_grtc_timer.h>
+#include "sysoff.h"
+#include "retained.h"
+#include "latency_hist.h"
+#include "power_acct.h"
+#include "mono_time.h"
+#include "grtc.h"
+
+LOG_MODULE_REGISTER(sysoff, LOG_LEVEL_INF);
+
+/* Wake-up latency per cycle in microseconds: programmed GRTC wake
+ * time until sysoff_report() runs in main().
+ */
+static LATENCY_HIST_DEFINE(wake_hist);
+
+void sysoff_report(void)
+{
+	uint64_t now = grtc_read_us();
+
+	(void)latency_hist_restore(&wake_hist, RETAINED_HIST_OFFSET);
+
+	if (retained.wake_target_grtc == 0U) {
+		return;
+	}
+
+	if (now >= retained.wake_target_grtc) {
+		uint64_t latency = now - retained.wake_target_grtc;
+
+		latency_hist_record(&wake_hist, (uint32_t)MIN(latency, UINT32_MAX));
+		LOG_INF("Woke from System OFF, latency %llu us", latency);
+	} else {
+		LOG_WRN("GRTC restarted during System OFF");
+	}
+
+	retained.wake_target_grtc = 0;
+	retained_update();
+	(void)latency_hist_save(&wake_hist, RETAINED_HIST_OFFSET);
+
+	LOG_INF("Wake latency over %u cycles: min %u, p50 %u, p99 %u, max %u us",
+		latency_hist_count(&wake_hist), latency_hist_min(&wake_hist),
+		latency_hist_percentile(&wake_hist, 500),
+		latency_hist_percentile(&wake_hist, 990),
+		latency_hist_max(&wake_hist));
+}
+
+uint32_t sysoff_cycles(void)
+{
+	return latency_hist_count(&wake_hist);
+}
+
+int sysoff_enter(uint32_t sleep_ms)
+{
+	uint64_t sleep_us = (uint64_t)sleep_ms * 1000U;
+	int err;
+
+	err = z_nrf_grtc_wakeup_prepare(sleep_us);
+	if (err < 0) {
+		/* Without a wake-up, only a pin reset would end System OFF */
+		LOG_ERR("GRTC wake-up setup failed (%d), staying on", err);
+		return err;
+	}
+
+	LOG_INF("Entering System OFF for %u ms", sleep_ms);
+	retained.wake_target_grtc = grtc_read_us() + sleep_us;
+
+#ifdef CONFIG_APP_POWER_ACCT
+	/* Stamps the GRTC and persists the retained data */
+	power_acct_enter_off();
+#else
+	retained_update();
+#endif
+	mono_time_seal();
+
+	sys_poweroff();
+}
@@ -0,0 +1,50 @@
+/*
+ * System OFF with GRTC wake-up - Header File
+ *
+ * Only the RAM blocks holding zephyr,retained-ram regions (the
+ * retained region with all boot handoff data) keep their retention
+ * enabled in System OFF; see CONFIG_RETAINED_MEM_NRF_RAM_CTRL in the
+ * board configuration.  The wake-up latency of every cycle is kept in
+ * a retained latency histogram.
+ */
+
+#ifndef SYSOFF_H
+#define SYSOFF_H
+
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+
+#ifdef CONFIG_APP_SYSOFF
+
+/**
+ * @brief Account a wake-up from System OFF
+ *
+ * Call early in main(), after retained_validate().  Logs the wake-up
+ * latency of this boot and the distribution over all cycles.
+ */
+void sysoff_report(void);
+
+/**
+ * @brief Number of System OFF cycles completed so far
+ */
+uint32_t sysoff_cycles(void);
+
+/**
+ * @brief Enter System OFF and wake up from the GRTC
+ *
+ * Returns only if the GRTC wake-up could not be set up, without
+ * entering System OFF.
+ *
+ * @param sleep_ms Time to stay in System OFF
+ * @return Negative error code from the wake-up setup
+ */
+int sysoff_enter(uint32_t sleep_ms);
+
+#else
+
+static inline void sysoff_report(void) {}
+static inline uint32_t sysoff_cycles(void) { return 0; }
+
+#endif /* CONFIG_APP_SYSOFF */
+
+#endif /* SYSOFF_H */
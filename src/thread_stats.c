@@ -0,0 +1,193 @@
+/*
+ * Per-thread runtime and stack statistics
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include "thread_stats.h"
+#include "retained.h"
+#include "coalesce.h"
+
+LOG_MODULE_REGISTER(thread_stats, LOG_LEVEL_INF);
+
+#define THREAD_STATS_MAX 8
+
+/* Threads whose cycle count is carried from one sample to the next;
+ * any further thread is reported with its share since it started.
+ */
+#define THREAD_STATS_TRACKED 32
+
+struct thread_stats_entry {
+	char name[12];
+	uint16_t cpu_permille;  /* Share of CPU time since the previous sample */
+	uint16_t reserved;
+	uint32_t stack_size;
+	uint32_t stack_unused;  /* Never-touched bytes: size - high-water */
+};
+
+struct thread_stats_snapshot {
+	uint32_t boot;          /* retained.boots of the sampled session */
+	uint32_t samples;
+	uint64_t uptime_ms;
+	uint32_t count;
+	struct thread_stats_entry threads[THREAD_STATS_MAX];
+};
+
+BUILD_ASSERT(sizeof(struct thread_stats_snapshot) + sizeof(uint32_t) <=
+	     RETAINED_THREAD_STATS_SIZE,
+	     "thread statistics do not fit their retained window");
+
+static struct thread_stats_snapshot snapshot;
+
+/* Cycle counts of the previous sample and the one being taken */
+struct thread_cycles {
+	const struct k_thread *thread;
+	uint64_t cycles;
+};
+
+static struct thread_cycles cycles[2][THREAD_STATS_TRACKED];
+static uint32_t cycles_count[2];
+static uint32_t cycles_cur;
+static uint64_t prev_total_cycles;
+static uint64_t period_cycles;
+
+/* Cycles the thread ran since the previous sample */
+static uint64_t thread_period_cycles(const struct k_thread *thread, uint64_t now)
+{
+	const struct thread_cycles *prev = cycles[cycles_cur ^ 1U];
+	uint64_t delta = now;
+
+	for (uint32_t i = 0; i < cycles_count[cycles_cur ^ 1U]; i++) {
+		if (prev[i].thread == thread) {
+			delta = (now >= prev[i].cycles) ? now - prev[i].cycles : 0;
+			break;
+		}
+	}
+
+	if (cycles_count[cycles_cur] < THREAD_STATS_TRACKED) {
+		cycles[cycles_cur][cycles_count[cycles_cur]++] = (struct thread_cycles) {
+			.thread = thread,
+			.cycles = now,
+		};
+	}
+
+	return delta;
+}
+
+#define THREAD_STATS_PERIOD_US ((uint32_t)CONFIG_APP_THREAD_STATS_PERIOD_MS * 1000U)
+
+#ifdef CONFIG_APP_COALESCE
+/* A quarter period of slack: the shares are over the actual period */
+static void thread_stats_fn(struct coalesce_task *task);
+static COALESCE_TASK_DEFINE(thread_stats, thread_stats_fn, THREAD_STATS_PERIOD_US,
+			    THREAD_STATS_PERIOD_US / 4U);
+#else
+static void thread_stats_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(thread_stats_work, thread_stats_work_handler);
+#endif
+
+static void collect_thread(const struct k_thread *cthread, void *user_data)
+{
+	struct k_thread *thread = (struct k_thread *)cthread;
+	k_thread_runtime_stats_t rt;
+	struct thread_stats_entry entry = { 0 };
+	const char *name = k_thread_name_get(thread);
+	size_t unused = 0;
+	uint64_t delta;
+	uint32_t slot;
+
+	ARG_UNUSED(user_data);
+
+	if (k_thread_runtime_stats_get(thread, &rt) != 0) {
+		rt.execution_cycles = 0;
+	}
+	(void)k_thread_stack_space_get(thread, &unused);
+
+	strncpy(entry.name, (name != NULL && name[0] != '\0') ? name : "?",
+		sizeof(entry.name) - 1);
+	delta = thread_period_cycles(thread, rt.execution_cycles);
+	entry.cpu_permille = (period_cycles != 0U) ?
+		(uint16_t)MIN(delta * 1000U / period_cycles, 1000U) : 0;
+	entry.stack_size = thread->stack_info.size;
+	entry.stack_unused = unused;
+
+	/* Keep the busiest threads, ordered by CPU share */
+	slot = snapshot.count;
+	if (slot == THREAD_STATS_MAX) {
+		if (entry.cpu_permille <= snapshot.threads[slot - 1].cpu_permille) {
+			return;
+		}
+		slot--;
+	} else {
+		snapshot.count++;
+	}
+	while (slot > 0 && snapshot.threads[slot - 1].cpu_permille < entry.cpu_permille) {
+		snapshot.threads[slot] = snapshot.threads[slot - 1];
+		slot--;
+	}
+	snapshot.threads[slot] = entry;
+}
+
+void thread_stats_sample(void)
+{
+	k_thread_runtime_stats_t all;
+	uint64_t total_cycles;
+
+	total_cycles = (k_thread_runtime_stats_all_get(&all) == 0) ? all.execution_cycles : 0;
+	period_cycles = (total_cycles >= prev_total_cycles) ? total_cycles - prev_total_cycles : 0;
+	prev_total_cycles = total_cycles;
+	cycles_cur ^= 1U;
+	cycles_count[cycles_cur] = 0;
+
+	snapshot.boot = retained.boots;
+	snapshot.samples++;
+	snapshot.uptime_ms = k_uptime_get();
+	snapshot.count = 0;
+	memset(snapshot.threads, 0, sizeof(snapshot.threads));
+
+	k_thread_foreach_unlocked(collect_thread, NULL);
+
+	(void)retained_blob_write(RETAINED_THREAD_STATS_OFFSET, &snapshot, sizeof(snapshot));
+}
+
+#ifdef CONFIG_APP_COALESCE
+static void thread_stats_fn(struct coalesce_task *task)
+{
+	ARG_UNUSED(task);
+	thread_stats_sample();
+}
+#else
+static void thread_stats_work_handler(struct k_work *work)
+{
+	thread_stats_sample();
+	k_work_schedule(&thread_stats_work, K_MSEC(CONFIG_APP_THREAD_STATS_PERIOD_MS));
+}
+#endif
+
+void thread_stats_init(void)
+{
+	struct thread_stats_snapshot prev;
+
+	if (retained_blob_read(RETAINED_THREAD_STATS_OFFSET, &prev, sizeof(prev)) == 0 &&
+	    prev.count <= THREAD_STATS_MAX) {
+		LOG_INF("=== Thread stats of previous session (boot %u) ===", prev.boot);
+		LOG_INF("  last sample at %llu ms uptime (%u samples)",
+			prev.uptime_ms, prev.samples);
+		for (uint32_t i = 0; i < prev.count; i++) {
+			const struct thread_stats_entry *t = &prev.threads[i];
+
+			LOG_INF("  %-12.12s cpu %3u.%u%%  stack %u/%u bytes used",
+				t->name, t->cpu_permille / 10U, t->cpu_permille % 10U,
+				t->stack_size - t->stack_unused, t->stack_size);
+		}
+	} else {
+		LOG_INF("No thread stats from a previous session");
+	}
+
+#ifdef CONFIG_APP_COALESCE
+	coalesce_schedule_in(&thread_stats, THREAD_STATS_PERIOD_US);
+#else
+	k_work_schedule(&thread_stats_work, K_MSEC(CONFIG_APP_THREAD_STATS_PERIOD_MS));
+#endif
+}
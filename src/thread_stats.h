@@ -0,0 +1,36 @@
+/*
+ * Per-thread runtime and stack statistics - Header File
+ *
+ * A periodic sampler stores each thread's share of CPU time and its
+ * stack high-water mark in the retained region, so the final values
+ * of a session that ended in a watchdog or fatal reset can be printed
+ * on the next boot.
+ */
+
+#ifndef THREAD_STATS_H
+#define THREAD_STATS_H
+
+#ifdef CONFIG_APP_THREAD_STATS
+
+/**
+ * @brief Log the previous session's statistics and start sampling
+ *
+ * Call once after retained_validate().
+ */
+void thread_stats_init(void);
+
+/**
+ * @brief Take a sample now and store it in the retained region
+ *
+ * Useful right before a deliberate reset.
+ */
+void thread_stats_sample(void);
+
+#else
+
+static inline void thread_stats_init(void) {}
+static inline void thread_stats_sample(void) {}
+
+#endif /* CONFIG_APP_THREAD_STATS */
+
+#endif /* THREAD_STATS_H */
@@ -8,9 +8,19 @@
  */
 
 #include <zephyr/kernel.h>
-#include <zephyr/drivers/timer/nrf_grtc_timer.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/barrier.h>
+#include <string.h>
 #include "utc_time.h"
+#include "grtc.h"
+#include "profile.h"
+#include "status.h"
+#include "coproc.h"
+#include "retained.h"
+#include "input_rec.h"
+#ifdef CONFIG_APP_COPROC
+#include "coproc_shm.h"
+#endif
 
 LOG_MODULE_REGISTER(utc_time, LOG_LEVEL_INF);
 
@@ -18,6 +28,78 @@ LOG_MODULE_REGISTER(utc_time, LOG_LEVEL_INF);
 static int64_t utc_offset = 0;
 static bool calibrated = false;
 
+#ifdef CONFIG_APP_EARLY_RESTORE
+/* Calibration kept in the retained UTC window */
+struct utc_persist {
+	int64_t offset_us;
+	/* GRTC when saved; a smaller GRTC at restore means it restarted */
+	uint64_t grtc_us;
+};
+
+BUILD_ASSERT(sizeof(struct utc_persist) + sizeof(uint32_t) <= RETAINED_UTC_SIZE,
+	     "UTC calibration does not fit its retained window");
+
+/* Set by a restore that found the GRTC restarted */
+static bool stale;
+
+static void persist(uint64_t grtc_us)
+{
+	struct utc_persist state = {
+		.offset_us = utc_offset,
+		.grtc_us = grtc_us,
+	};
+
+	stale = false;
+
+	(void)retained_blob_write(RETAINED_UTC_OFFSET, &state, sizeof(state));
+}
+
+static int restore(void)
+{
+	struct utc_persist state;
+
+	calibrated = false;
+	utc_offset = 0;
+
+	if (retained_blob_read(RETAINED_UTC_OFFSET, &state, sizeof(state)) != 0) {
+		return -ENOENT;
+	}
+	if (grtc_read_us() < state.grtc_us) {
+		stale = true;
+		return -ESTALE;
+	}
+
+	utc_offset = state.offset_us;
+	calibrated = true;
+	return 0;
+}
+
+int utc_time_restore(void)
+{
+	input_rec_begin(INPUT_REC_CALL_RESTORE, 0);
+
+	return (int)input_rec_end((uint64_t)restore());
+}
+
+void utc_time_publish(void)
+{
+	uint64_t grtc_time = grtc_read_us();
+
+	/* The restarted GRTC would pass the saved timestamp after a while
+	 * and a later restore would take the old offset: drop it.  Not
+	 * done in utc_time_restore(), which runs before the driver.
+	 */
+	if (stale) {
+		persist(UINT64_MAX);
+	}
+
+	status_publish_clock(calibrated, utc_offset);
+	if (calibrated) {
+		coproc_post_calibration(grtc_time + utc_offset, grtc_time);
+	}
+}
+#endif /* CONFIG_APP_EARLY_RESTORE */
+
 /**
  * @brief Calibrate UTC time with external time source
  * 
@@ -25,7 +107,9 @@ static bool calibrated = false;
  */
 void utc_time_calibrate(uint64_t utc_timestamp_us)
 {
-	uint64_t grtc_time = z_nrf_grtc_timer_read();
+	input_rec_begin(INPUT_REC_CALL_CALIBRATE, utc_timestamp_us);
+
+	uint64_t grtc_time = grtc_read_us();
 	utc_offset = (int64_t)utc_timestamp_us - (int64_t)grtc_time;
 	calibrated = true;
 	
@@ -33,6 +117,23 @@ void utc_time_calibrate(uint64_t utc_timestamp_us)
 	LOG_INF("  GRTC time: %llu us", grtc_time);
 	LOG_INF("  UTC time:  %llu us", utc_timestamp_us);
 	LOG_INF("  Offset:    %lld us", utc_offset);
+
+	status_publish_clock(calibrated, utc_offset);
+	coproc_post_calibration(utc_timestamp_us, grtc_time);
+#ifdef CONFIG_APP_EARLY_RESTORE
+	persist(grtc_time);
+#endif
+	(void)input_rec_end(utc_offset);
+}
+
+void utc_time_invalidate(void)
+{
+	input_rec_begin(INPUT_REC_CALL_INVALIDATE, 0);
+	calibrated = false;
+	utc_offset = 0;
+	(void)input_rec_end(0);
+
+	status_publish_clock(calibrated, utc_offset);
 }
 
 /**
@@ -46,6 +147,188 @@ void utc_time_calibrate_unix(uint64_t unix_timestamp)
 	utc_time_calibrate(utc_us);
 }
 
+/**
+ * @brief Calibrate UTC time with an RFC 3339 timestamp string
+ *
+ * @param str NUL-terminated timestamp
+ * @return 0 on success, -EINVAL if the string is not valid RFC 3339
+ */
+int utc_time_calibrate_str(const char *str)
+{
+	uint64_t utc_us;
+	int err;
+
+	err = utc_time_parse_rfc3339(str, strlen(str), &utc_us);
+	if (err) {
+		LOG_ERR("Invalid RFC 3339 time: %s", str);
+		return err;
+	}
+
+	utc_time_calibrate(utc_us);
+	return 0;
+}
+
+/* Read exactly @p n decimal digits at @p p, or return -1 */
+static inline int parse_digits(const char *p, int n)
+{
+	int v = 0;
+
+	for (int i = 0; i < n; i++) {
+		unsigned int d = (unsigned int)(p[i] - '0');
+
+		if (d > 9U) {
+			return -1;
+		}
+		v = v * 10 + (int)d;
+	}
+
+	return v;
+}
+
+static inline bool is_leap_year(int y)
+{
+	return (y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0));
+}
+
+/* Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant) */
+static int64_t days_from_civil(int y, int m, int d)
+{
+	y -= m <= 2;
+
+	int era = y / 400;
+	int yoe = y - era * 400;
+	int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return (int64_t)era * 146097 + doe - 719468;
+}
+
+/* Inverse of days_from_civil() for days >= 0 (H. Hinnant) */
+static void civil_from_days(uint32_t z, int *y, unsigned int *m, unsigned int *d)
+{
+	z += 719468;
+
+	uint32_t era = z / 146097;
+	uint32_t doe = z - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+
+	*d = doy - (153 * mp + 2) / 5 + 1;
+	*m = mp < 10 ? mp + 3 : mp - 9;
+	*y = (int)(yoe + era * 400) + (*m <= 2);
+}
+
+/**
+ * @brief Parse an RFC 3339 timestamp into UTC microseconds
+ *
+ * @param str Timestamp characters
+ * @param len Number of characters in @p str
+ * @param utc_us Output UTC timestamp in microseconds
+ * @return 0 on success, -EINVAL on malformed input
+ */
+int utc_time_parse_rfc3339(const char *str, size_t len, uint64_t *utc_us)
+{
+	static const uint8_t days_in_month[12] = {
+		31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+	};
+	const char *p = str;
+	const char *end = str + len;
+	int year, month, day, hour, minute, second;
+	int32_t frac_us = 0;
+	int32_t offset_min = 0;
+
+	/* "YYYY-MM-DDTHH:MM:SS" is the fixed-width prefix */
+	if (len < 20) {
+		return -EINVAL;
+	}
+
+	year = parse_digits(p, 4);
+	month = parse_digits(p + 5, 2);
+	day = parse_digits(p + 8, 2);
+	hour = parse_digits(p + 11, 2);
+	minute = parse_digits(p + 14, 2);
+	second = parse_digits(p + 17, 2);
+
+	if (p[4] != '-' || p[7] != '-' ||
+	    (p[10] != 'T' && p[10] != 't' && p[10] != ' ') ||
+	    p[13] != ':' || p[16] != ':') {
+		return -EINVAL;
+	}
+
+	/* parse_digits() returns -1 on error, which also fails these */
+	if (year < 1970 || month < 1 || month > 12 || day < 1 ||
+	    hour < 0 || hour > 23 || minute < 0 || minute > 59 ||
+	    second < 0 || second > 60) {
+		return -EINVAL;
+	}
+
+	if (day > days_in_month[month - 1] +
+		  ((month == 2 && is_leap_year(year)) ? 1 : 0)) {
+		return -EINVAL;
+	}
+
+	p += 19;
+
+	if (*p == '.') {
+		int digits = 0;
+
+		p++;
+		while (p < end && (unsigned int)(*p - '0') <= 9U) {
+			if (digits < 6) {
+				frac_us = frac_us * 10 + (*p - '0');
+			}
+			digits++;
+			p++;
+		}
+		if (digits == 0) {
+			return -EINVAL;
+		}
+		for (; digits < 6; digits++) {
+			frac_us *= 10;
+		}
+	}
+
+	if (p >= end) {
+		return -EINVAL;
+	}
+
+	if (*p == 'Z' || *p == 'z') {
+		p++;
+	} else if (*p == '+' || *p == '-') {
+		int sign = (*p == '-') ? -1 : 1;
+		int off_h, off_m;
+
+		if (end - p < 6 || p[3] != ':') {
+			return -EINVAL;
+		}
+		off_h = parse_digits(p + 1, 2);
+		off_m = parse_digits(p + 4, 2);
+		if (off_h < 0 || off_h > 23 || off_m < 0 || off_m > 59) {
+			return -EINVAL;
+		}
+		offset_min = sign * (off_h * 60 + off_m);
+		p += 6;
+	} else {
+		return -EINVAL;
+	}
+
+	if (p != end) {
+		return -EINVAL;
+	}
+
+	int64_t sec = days_from_civil(year, month, day) * 86400 +
+		      hour * 3600 + minute * 60 + second -
+		      (int64_t)offset_min * 60;
+
+	if (sec < 0) {
+		return -EINVAL;
+	}
+
+	*utc_us = (uint64_t)sec * 1000000ULL + (uint64_t)frac_us;
+	return 0;
+}
+
 /**
  * @brief Check if UTC time is calibrated
  * 
@@ -63,14 +346,62 @@ bool utc_time_is_calibrated(void)
  */
 uint64_t utc_time_get_us(void)
 {
-	uint64_t grtc_time = z_nrf_grtc_timer_read();
+	PROFILE_SCOPE(UTC_GET_US);
+	input_rec_begin(INPUT_REC_CALL_GET_US, 0);
+	uint64_t grtc_time = grtc_read_us();
+
+#ifdef CONFIG_APP_COPROC
+	/* Drift-corrected model from the coprocessor clock filter */
+	struct coproc_clock clock;
+
+	if (coproc_clock_get(&clock)) {
+		return input_rec_end(coproc_clock_utc_us(&clock, grtc_time));
+	}
+#endif
 	
 	if (!calibrated) {
 		LOG_WRN("UTC time not calibrated, returning raw GRTC time");
-		return grtc_time;
+		return input_rec_end(grtc_time);
 	}
 	
-	return grtc_time + utc_offset;
+	return input_rec_end(grtc_time + utc_offset);
+}
+
+uint64_t utc_time_from_grtc(uint64_t grtc_us)
+{
+#ifdef CONFIG_APP_COPROC
+	struct coproc_clock clock;
+
+	if (coproc_clock_get(&clock)) {
+		return coproc_clock_utc_us(&clock, grtc_us);
+	}
+#endif
+
+	return calibrated ? grtc_us + utc_offset : grtc_us;
+}
+
+int utc_time_to_grtc(uint64_t utc_us, uint64_t *grtc_us)
+{
+#ifdef CONFIG_APP_COPROC
+	struct coproc_clock clock;
+
+	if (coproc_clock_get(&clock)) {
+		/* One correction step: the drift term changes by far less
+		 * than a microsecond over the step for ppm-level drift.
+		 */
+		uint64_t grtc = utc_us - clock.offset_us;
+
+		*grtc_us = grtc - (coproc_clock_utc_us(&clock, grtc) - utc_us);
+		return 0;
+	}
+#endif
+
+	if (!calibrated) {
+		return -EAGAIN;
+	}
+
+	*grtc_us = utc_us - utc_offset;
+	return 0;
 }
 
 /**
@@ -150,6 +481,7 @@ int64_t utc_time_diff_us(uint64_t time1, uint64_t time2)
  */
 int utc_time_format_us(uint64_t us, char *buffer, size_t size)
 {
+	PROFILE_SCOPE(UTC_FORMAT);
 	uint64_t sec = us / 1000000ULL;
 	uint64_t ms = (us / 1000ULL) % 1000ULL;
 	uint64_t remaining_us = us % 1000ULL;
@@ -169,3 +501,229 @@ int utc_time_format(char *buffer, size_t size)
 	uint64_t us = utc_time_get_us();
 	return utc_time_format_us(us, buffer, size);
 }
+
+/* "YYYY-MM-DDTHH:MM:SS", then ".uuuuuuZ" */
+#define ISO_PREFIX_LEN 19
+#define ISO_LEN (ISO_PREFIX_LEN + 8)
+
+/* Last rendered prefix, a seqlock: seq is odd while it is rewritten */
+static struct {
+	atomic_t seq;
+	uint64_t sec;
+	char prefix[ISO_PREFIX_LEN];
+} iso_cache = {
+	.sec = UINT64_MAX,
+};
+
+static void render_iso_prefix(uint64_t sec, char *out)
+{
+	uint32_t sod = (uint32_t)(sec % 86400U);
+	int y;
+	unsigned int m, d;
+
+	civil_from_days((uint32_t)(sec / 86400U), &y, &m, &d);
+
+	char tmp[ISO_PREFIX_LEN + 1];
+
+	(void)snprintf(tmp, sizeof(tmp), "%04d-%02u-%02uT%02u:%02u:%02u", y, m, d,
+		       sod / 3600U, (sod / 60U) % 60U, sod % 60U);
+	memcpy(out, tmp, ISO_PREFIX_LEN);
+}
+
+int utc_time_format_iso_us(uint64_t us, char *buffer, size_t size)
+{
+	uint64_t sec = us / 1000000ULL;
+	uint32_t frac = (uint32_t)(us % 1000000ULL);
+	bool hit = false;
+
+	if (size < ISO_LEN + 1) {
+		return -ENOSPC;
+	}
+	if (sec > UTC_TIME_ISO_MAX_SEC) {
+		return -ERANGE;
+	}
+
+	/* One read attempt, no spinning: the writer may be a preempted
+	 * thread and this an interrupt.  A miss renders the prefix.
+	 */
+	atomic_val_t seq = atomic_get(&iso_cache.seq);
+
+	if ((seq & 1) == 0 && iso_cache.sec == sec) {
+		memcpy(buffer, iso_cache.prefix, ISO_PREFIX_LEN);
+		barrier_dmem_fence_full();
+		hit = (atomic_get(&iso_cache.seq) == seq);
+	}
+
+	if (!hit) {
+		render_iso_prefix(sec, buffer);
+
+		/* Publish unless another writer holds the cache */
+		seq = atomic_get(&iso_cache.seq);
+		if ((seq & 1) == 0 && atomic_cas(&iso_cache.seq, seq, seq + 1)) {
+			barrier_dmem_fence_full();
+			iso_cache.sec = sec;
+			memcpy(iso_cache.prefix, buffer, ISO_PREFIX_LEN);
+			barrier_dmem_fence_full();
+			atomic_set(&iso_cache.seq, seq + 2);
+		}
+	}
+
+	char *p = buffer + ISO_PREFIX_LEN;
+
+	p[0] = '.';
+	for (int i = 6; i > 0; i--) {
+		p[i] = (char)('0' + frac % 10U);
+		frac /= 10U;
+	}
+	p[7] = 'Z';
+	p[8] = '\0';
+
+	return ISO_LEN;
+}
+
+/*
+ * NTP / PTP conversions
+ *
+ * None of the helpers below use a 64-bit division: quotients are
+ * estimated with a multiply by a fixed-point reciprocal and then
+ * corrected with a single compare, so the result is exact.
+ */
+
+/* Seconds between 1900-01-01 (NTP epoch) and 1970-01-01 (Unix epoch) */
+#define NTP_UNIX_OFFSET_SEC 2208988800ULL
+
+/* floor(2^64 / 10^6) */
+#define RECIP_1E6_Q64 18446744073709ULL
+
+/* 2^32 / 10^6 = 4294 + 15114 / 15625 */
+#define NTP_FRAC_INT  4294U
+#define NTP_FRAC_NUM  15114U
+#define NTP_FRAC_DEN  15625U
+
+/* floor(2^40 / 15625) */
+#define RECIP_15625_Q40 70368744ULL
+
+/* High 64 bits of a 64x64 product, built from 32x32 multiplies */
+static inline uint64_t mulhi64(uint64_t a, uint64_t b)
+{
+	uint64_t a_lo = (uint32_t)a;
+	uint64_t a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t)b;
+	uint64_t b_hi = b >> 32;
+
+	uint64_t lo_lo = a_lo * b_lo;
+	uint64_t lo_hi = a_lo * b_hi;
+	uint64_t hi_lo = a_hi * b_lo;
+	uint64_t hi_hi = a_hi * b_hi;
+
+	uint64_t mid = (lo_lo >> 32) + (uint32_t)lo_hi + (uint32_t)hi_lo;
+
+	return hi_hi + (lo_hi >> 32) + (hi_lo >> 32) + (mid >> 32);
+}
+
+/* Split microseconds into whole seconds and the microsecond remainder */
+static inline uint64_t us_split(uint64_t us, uint32_t *rem_us)
+{
+	/* The estimate is either exact or one too small */
+	uint64_t sec = mulhi64(us, RECIP_1E6_Q64);
+	uint64_t rem = us - sec * 1000000ULL;
+
+	if (rem >= 1000000ULL) {
+		sec++;
+		rem -= 1000000ULL;
+	}
+
+	*rem_us = (uint32_t)rem;
+	return sec;
+}
+
+/* ceil(rem_us * 2^32 / 10^6) for rem_us < 10^6.  Rounding up makes
+ * utc_time_ntp_to_us() return the original microsecond value.
+ */
+static inline uint32_t us_to_ntp_frac(uint32_t rem_us)
+{
+	uint64_t n = (uint64_t)rem_us * NTP_FRAC_NUM;
+	uint64_t q = (n * RECIP_15625_Q40) >> 40;
+	uint64_t r = n - q * NTP_FRAC_DEN;
+
+	if (r >= NTP_FRAC_DEN) {
+		q++;
+		r -= NTP_FRAC_DEN;
+	}
+	if (r != 0) {
+		q++;
+	}
+
+	return rem_us * NTP_FRAC_INT + (uint32_t)q;
+}
+
+/* floor(ns / 1000), exact for every 32-bit ns */
+static inline uint32_t ns_to_us(uint32_t ns)
+{
+	return (uint32_t)(((uint64_t)ns * 0x10624DD3ULL) >> 38);
+}
+
+void utc_time_us_to_ntp(uint64_t us, utc_ntp_time_t *ntp)
+{
+	uint32_t rem_us;
+	uint64_t sec = us_split(us, &rem_us);
+
+	ntp->seconds = (uint32_t)(sec + NTP_UNIX_OFFSET_SEC);
+	ntp->fraction = us_to_ntp_frac(rem_us);
+}
+
+uint64_t utc_time_ntp_to_us(const utc_ntp_time_t *ntp)
+{
+	uint64_t sec = ntp->seconds;
+
+	/* Era 1 starts on 2036-02-07 06:28:16 UTC */
+	if (sec < NTP_UNIX_OFFSET_SEC) {
+		sec += 1ULL << 32;
+	}
+
+	return (sec - NTP_UNIX_OFFSET_SEC) * 1000000ULL +
+	       (((uint64_t)ntp->fraction * 1000000ULL) >> 32);
+}
+
+void utc_time_us_to_ptp(uint64_t us, utc_ptp_time_t *ptp)
+{
+	uint32_t rem_us;
+	uint64_t sec = us_split(us, &rem_us);
+
+	ptp->seconds = sec & 0xFFFFFFFFFFFFULL;
+	ptp->nanoseconds = rem_us * 1000U;
+}
+
+uint64_t utc_time_ptp_to_us(const utc_ptp_time_t *ptp)
+{
+	return (ptp->seconds & 0xFFFFFFFFFFFFULL) * 1000000ULL +
+	       ns_to_us(ptp->nanoseconds);
+}
+
+void utc_time_us_to_ntp_batch(const uint64_t *us, utc_ntp_time_t *ntp, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		utc_time_us_to_ntp(us[i], &ntp[i]);
+	}
+}
+
+void utc_time_ntp_to_us_batch(const utc_ntp_time_t *ntp, uint64_t *us, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		us[i] = utc_time_ntp_to_us(&ntp[i]);
+	}
+}
+
+void utc_time_us_to_ptp_batch(const uint64_t *us, utc_ptp_time_t *ptp, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		utc_time_us_to_ptp(us[i], &ptp[i]);
+	}
+}
+
+void utc_time_ptp_to_us_batch(const utc_ptp_time_t *ptp, uint64_t *us, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		us[i] = utc_time_ptp_to_us(&ptp[i]);
+	}
+}
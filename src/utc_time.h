@@ -22,6 +22,25 @@ typedef struct {
 	bool calibrated;        /**< Whether time is calibrated */
 } utc_time_t;
 
+/**
+ * @brief NTP 32.32 timestamp (seconds since 1900-01-01, era 0/1)
+ */
+typedef struct {
+	uint32_t seconds;       /**< NTP seconds */
+	uint32_t fraction;      /**< Fraction of a second in units of 2^-32 s */
+} utc_ntp_time_t;
+
+/**
+ * @brief PTP 48.32 timestamp (seconds + nanoseconds)
+ *
+ * Seconds are counted from the Unix epoch on the same timescale as
+ * utc_time_get_us(); no TAI/UTC leap second offset is applied.
+ */
+typedef struct {
+	uint64_t seconds;       /**< Seconds, only the low 48 bits are used */
+	uint32_t nanoseconds;   /**< Nanoseconds, 0 .. 999999999 */
+} utc_ptp_time_t;
+
 /**
  * @brief Calibrate UTC time with external time source
  * 
@@ -36,6 +55,40 @@ void utc_time_calibrate(uint64_t utc_timestamp_us);
  */
 void utc_time_calibrate_unix(uint64_t unix_timestamp);
 
+/**
+ * @brief Calibrate UTC time with an RFC 3339 timestamp string
+ *
+ * Keeps the full microsecond precision of the string, see
+ * utc_time_parse_rfc3339().
+ *
+ * @param str NUL-terminated timestamp, e.g. "2025-12-11T08:30:00.250Z"
+ * @return 0 on success, -EINVAL if the string is not valid RFC 3339
+ */
+int utc_time_calibrate_str(const char *str);
+
+/**
+ * @brief Parse an RFC 3339 timestamp into UTC microseconds
+ *
+ * Accepts YYYY-MM-DDTHH:MM:SS[.frac](Z|+HH:MM|-HH:MM) in a single pass
+ * without allocation.  'T' may also be 't' or a space, and 'Z' may be
+ * 'z'.  Fractions longer than six digits are truncated.  A leap second
+ * (SS = 60) is folded into the following second.  Dates before
+ * 1970-01-01T00:00:00Z are rejected.
+ *
+ * @param str Timestamp characters (need not be NUL-terminated)
+ * @param len Number of characters in @p str
+ * @param utc_us Output UTC timestamp in microseconds
+ * @return 0 on success, -EINVAL on malformed input
+ */
+int utc_time_parse_rfc3339(const char *str, size_t len, uint64_t *utc_us);
+
+/**
+ * @brief Drop the calibration, as after a reset
+ *
+ * Publishes the change; the persisted calibration is kept.
+ */
+void utc_time_invalidate(void);
+
 /**
  * @brief Check if UTC time is calibrated
  * 
@@ -50,6 +103,54 @@ bool utc_time_is_calibrated(void);
  */
 uint64_t utc_time_get_us(void);
 
+/**
+ * @brief Convert a UTC instant to the GRTC value it will occur at
+ *
+ * Inverse of utc_time_get_us(), including the coprocessor drift model
+ * with CONFIG_APP_COPROC.  Used to program GRTC compares for UTC
+ * deadlines; re-convert after each recalibration (clock_state_chan).
+ *
+ * @param utc_us UTC timestamp in microseconds
+ * @param grtc_us Output GRTC value (1 MHz ticks)
+ * @return 0 on success, -EAGAIN if the clock is not calibrated
+ */
+int utc_time_to_grtc(uint64_t utc_us, uint64_t *grtc_us);
+
+/**
+ * @brief Convert a GRTC value to UTC
+ *
+ * Same model as utc_time_get_us() but neither logs nor profiles, so
+ * it can serve as the log timestamp source.
+ *
+ * @param grtc_us GRTC value (1 MHz ticks)
+ * @return UTC timestamp in microseconds, or @p grtc_us if not calibrated
+ */
+uint64_t utc_time_from_grtc(uint64_t grtc_us);
+
+#ifdef CONFIG_APP_EARLY_RESTORE
+/**
+ * @brief Restore the calibration persisted by utc_time_calibrate()
+ *
+ * Dependency-free, for the PRE_KERNEL_1 hook in early_init.c.  The
+ * stored offset is only trusted if the GRTC has not gone backwards
+ * since it was saved (i.e. kept running through the reset).  The
+ * clock is left uncalibrated otherwise, as after a boot.
+ *
+ * @return 0 if restored, -ENOENT if nothing valid was stored, -ESTALE
+ * if the GRTC restarted
+ */
+int utc_time_restore(void);
+
+/**
+ * @brief Publish the current calibration on clock_state_chan and to
+ * the coprocessor, once the kernel runs after utc_time_restore()
+ *
+ * After an -ESTALE restore this also invalidates the stored
+ * calibration, which the restarted GRTC would otherwise catch up with.
+ */
+void utc_time_publish(void);
+#endif
+
 /**
  * @brief Get current UTC timestamp in milliseconds
  * 
@@ -95,6 +196,26 @@ int64_t utc_time_diff_us(uint64_t time1, uint64_t time2);
  */
 int utc_time_format_us(uint64_t us, char *buffer, size_t size);
 
+/* Last second utc_time_format_iso_us() renders: 9999-12-31T23:59:59 */
+#define UTC_TIME_ISO_MAX_SEC 253402300799ULL
+
+/**
+ * @brief Format UTC microseconds as "YYYY-MM-DDTHH:MM:SS.uuuuuuZ"
+ *
+ * For high-rate stamping: the date and time prefix of the last second
+ * formatted is cached, so calls within the same second only render
+ * the six sub-second digits.  Safe from any context; concurrent
+ * callers that miss the cache, or race its update, render the prefix
+ * themselves.
+ *
+ * @param us UTC timestamp in microseconds
+ * @param buffer Output buffer, at least 28 bytes
+ * @param size Buffer size
+ * @return 27 (characters written, without the NUL), -ENOSPC if the
+ * buffer is too small, -ERANGE past UTC_TIME_ISO_MAX_SEC
+ */
+int utc_time_format_iso_us(uint64_t us, char *buffer, size_t size);
+
 /**
  * @brief Format current UTC time to human-readable string
  * 
@@ -104,4 +225,77 @@ int utc_time_format_us(uint64_t us, char *buffer, size_t size);
  */
 int utc_time_format(char *buffer, size_t size);
 
+/**
+ * @brief Convert UTC microseconds to an NTP 32.32 timestamp
+ *
+ * Exact and free of 64-bit divisions.  The fraction is rounded up so
+ * that utc_time_ntp_to_us() gives back the original value.
+ *
+ * @param us UTC timestamp in microseconds
+ * @param ntp Output NTP timestamp
+ */
+void utc_time_us_to_ntp(uint64_t us, utc_ntp_time_t *ntp);
+
+/**
+ * @brief Convert an NTP 32.32 timestamp to UTC microseconds
+ *
+ * NTP seconds below the Unix epoch are treated as era 1 (after 2036).
+ *
+ * @param ntp NTP timestamp
+ * @return UTC timestamp in microseconds (fraction truncated)
+ */
+uint64_t utc_time_ntp_to_us(const utc_ntp_time_t *ntp);
+
+/**
+ * @brief Convert UTC microseconds to a PTP seconds + nanoseconds timestamp
+ *
+ * @param us UTC timestamp in microseconds
+ * @param ptp Output PTP timestamp
+ */
+void utc_time_us_to_ptp(uint64_t us, utc_ptp_time_t *ptp);
+
+/**
+ * @brief Convert a PTP seconds + nanoseconds timestamp to UTC microseconds
+ *
+ * @param ptp PTP timestamp
+ * @return UTC timestamp in microseconds (nanoseconds truncated)
+ */
+uint64_t utc_time_ptp_to_us(const utc_ptp_time_t *ptp);
+
+/**
+ * @brief Convert an array of UTC microsecond timestamps to NTP
+ *
+ * @param us Input timestamps
+ * @param ntp Output NTP timestamps
+ * @param count Number of entries
+ */
+void utc_time_us_to_ntp_batch(const uint64_t *us, utc_ntp_time_t *ntp, size_t count);
+
+/**
+ * @brief Convert an array of NTP timestamps to UTC microseconds
+ *
+ * @param ntp Input NTP timestamps
+ * @param us Output timestamps
+ * @param count Number of entries
+ */
+void utc_time_ntp_to_us_batch(const utc_ntp_time_t *ntp, uint64_t *us, size_t count);
+
+/**
+ * @brief Convert an array of UTC microsecond timestamps to PTP
+ *
+ * @param us Input timestamps
+ * @param ptp Output PTP timestamps
+ * @param count Number of entries
+ */
+void utc_time_us_to_ptp_batch(const uint64_t *us, utc_ptp_time_t *ptp, size_t count);
+
+/**
+ * @brief Convert an array of PTP timestamps to UTC microseconds
+ *
+ * @param ptp Input PTP timestamps
+ * @param us Output timestamps
+ * @param count Number of entries
+ */
+void utc_time_ptp_to_us_batch(const utc_ptp_time_t *ptp, uint64_t *us, size_t count);
+
 #endif /* UTC_TIME_H */
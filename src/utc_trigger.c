@@ -0,0 +1,256 @@
+/*
+ * UTC-triggered peripheral tasks
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include "utc_trigger.h"
+#include "grtc.h"
+#include "status.h"
+#include "utc_time.h"
+
+#ifdef CONFIG_APP_UTC_TRIGGER_DEMO
+#include <zephyr/devicetree.h>
+#include <hal/nrf_timer.h>
+#include "latency_hist.h"
+#endif
+
+LOG_MODULE_REGISTER(utc_trigger, LOG_LEVEL_INF);
+
+/* Armed triggers, re-converted on recalibration */
+static sys_slist_t armed_list = SYS_SLIST_STATIC_INIT(&armed_list);
+static struct k_spinlock lock;
+
+/* Caller holds the lock */
+static void disarm(struct utc_trigger *trigger)
+{
+	if (trigger->armed) {
+		grtc_trigger_cancel(&trigger->grtc);
+		(void)sys_slist_find_and_remove(&armed_list, &trigger->node);
+		trigger->armed = false;
+	}
+}
+
+static void fire_handler(int32_t id, uint64_t cc_value, void *user_data)
+{
+	struct utc_trigger *trigger = user_data;
+	utc_trigger_handler_t handler;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	ARG_UNUSED(id);
+
+	(void)sys_slist_find_and_remove(&armed_list, &trigger->node);
+	trigger->armed = false;
+	handler = trigger->handler;
+	k_spin_unlock(&lock, key);
+
+	/* Outside the lock: the handler may re-arm */
+	if (handler != NULL) {
+		handler(trigger, cc_value);
+	}
+}
+
+int utc_trigger_arm(struct utc_trigger *trigger, uint64_t utc_us,
+		    utc_trigger_handler_t handler)
+{
+	uint64_t grtc;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	int err;
+
+	disarm(trigger);
+
+	err = utc_time_to_grtc(utc_us, &grtc);
+	if (err == 0 && grtc <= grtc_read_us()) {
+		err = -ETIME;
+	}
+	if (err == 0) {
+		trigger->utc_us = utc_us;
+		trigger->handler = handler;
+		err = grtc_trigger_arm(&trigger->grtc, grtc, fire_handler, trigger);
+	}
+	if (err == 0) {
+		sys_slist_append(&armed_list, &trigger->node);
+		trigger->armed = true;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	return err;
+}
+
+void utc_trigger_cancel(struct utc_trigger *trigger)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	disarm(trigger);
+	k_spin_unlock(&lock, key);
+}
+
+static void utc_trigger_clock_cb(const struct zbus_channel *chan)
+{
+	const struct clock_state_msg *msg = zbus_chan_const_msg(chan);
+	struct utc_trigger *trigger;
+	struct utc_trigger *next;
+	uint32_t moved = 0;
+	uint32_t dropped = 0;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&armed_list, trigger, next, node) {
+		uint64_t grtc;
+
+		/* A deadline now in the past fires at once */
+		if (msg->calibrated &&
+		    utc_time_to_grtc(trigger->utc_us, &grtc) == 0 &&
+		    grtc_trigger_arm(&trigger->grtc, grtc, fire_handler, trigger) == 0) {
+			moved++;
+			continue;
+		}
+
+		disarm(trigger);
+		dropped++;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	if (moved != 0U || dropped != 0U) {
+		LOG_INF("Clock change: %u triggers re-armed, %u dropped", moved, dropped);
+	}
+}
+
+ZBUS_LISTENER_DEFINE(utc_trigger_clock_listener, utc_trigger_clock_cb);
+
+int utc_trigger_init(struct utc_trigger *trigger, uint32_t task_addr)
+{
+	static atomic_t listening;
+
+	if (atomic_cas(&listening, 0, 1)) {
+		int err = zbus_chan_add_obs(&clock_state_chan, &utc_trigger_clock_listener,
+					    K_MSEC(100));
+
+		if (err) {
+			atomic_clear(&listening);
+			return err;
+		}
+	}
+
+	trigger->armed = false;
+	trigger->handler = NULL;
+
+	return grtc_trigger_init(&trigger->grtc, task_addr);
+}
+
+#ifdef CONFIG_APP_UTC_TRIGGER_DEMO
+
+#define DEMO_PERIOD_US 1000000ULL
+
+/* Log the start error every this many starts */
+#define DEMO_REPORT_STARTS 10U
+
+static NRF_TIMER_Type *const demo_timer =
+	(NRF_TIMER_Type *)DT_REG_ADDR(DT_NODELABEL(test_timer));
+
+static struct utc_trigger demo;
+static uint32_t demo_starts;
+
+/* |GRTC time since the compare - timer count| per start in microseconds */
+static LATENCY_HIST_DEFINE(start_error_hist);
+
+static void demo_report_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+	utc_trigger_demo_print();
+}
+
+static K_WORK_DEFINE(demo_report_work, demo_report_work_handler);
+
+static void demo_handler(struct utc_trigger *trigger, uint64_t grtc_us);
+
+/* Arm the next whole UTC second at least half a period ahead */
+static void demo_arm(void)
+{
+	uint64_t next = (utc_time_get_us() + DEMO_PERIOD_US / 2U) / DEMO_PERIOD_US + 1U;
+
+	(void)utc_trigger_arm(&demo, next * DEMO_PERIOD_US, demo_handler);
+}
+
+static void demo_handler(struct utc_trigger *trigger, uint64_t grtc_us)
+{
+	/* Both count at 1 MHz from the compare: the difference is how
+	 * late the timer started, within one tick.
+	 */
+	uint64_t since_compare = grtc_read_us() - grtc_us;
+	uint32_t count;
+	uint64_t error;
+
+	nrf_timer_task_trigger(demo_timer, NRF_TIMER_TASK_CAPTURE0);
+	count = nrf_timer_cc_get(demo_timer, NRF_TIMER_CC_CHANNEL0);
+	nrf_timer_task_trigger(demo_timer, NRF_TIMER_TASK_STOP);
+	nrf_timer_task_trigger(demo_timer, NRF_TIMER_TASK_CLEAR);
+
+	error = (since_compare > count) ? since_compare - count : count - since_compare;
+	latency_hist_record(&start_error_hist, (uint32_t)MIN(error, UINT32_MAX));
+
+	if (++demo_starts % DEMO_REPORT_STARTS == 0U) {
+		k_work_submit(&demo_report_work);
+	}
+
+	/* After a step of the clock the next second may already be gone */
+	if (utc_trigger_arm(trigger, trigger->utc_us + DEMO_PERIOD_US, demo_handler) != 0) {
+		demo_arm();
+	}
+}
+
+/* Starts the train on first calibration; re-arming is done above */
+static void demo_clock_cb(const struct zbus_channel *chan)
+{
+	const struct clock_state_msg *msg = zbus_chan_const_msg(chan);
+
+	if (msg->calibrated && !demo.armed) {
+		demo_arm();
+	}
+}
+
+ZBUS_LISTENER_DEFINE(utc_trigger_demo_listener, demo_clock_cb);
+
+int utc_trigger_demo_init(void)
+{
+	int err;
+
+	nrf_timer_mode_set(demo_timer, NRF_TIMER_MODE_TIMER);
+	nrf_timer_bit_width_set(demo_timer, NRF_TIMER_BIT_WIDTH_32);
+	nrf_timer_prescaler_set(demo_timer,
+		NRF_TIMER_PRESCALER_CALCULATE(NRF_TIMER_BASE_FREQUENCY_GET(demo_timer), 1000000));
+	nrf_timer_task_trigger(demo_timer, NRF_TIMER_TASK_CLEAR);
+
+	err = utc_trigger_init(&demo, nrf_timer_task_address_get(demo_timer,
+								  NRF_TIMER_TASK_START));
+	if (err) {
+		LOG_ERR("UTC trigger demo setup failed (%d)", err);
+		return err;
+	}
+
+	err = zbus_chan_add_obs(&clock_state_chan, &utc_trigger_demo_listener, K_MSEC(100));
+	if (err) {
+		return err;
+	}
+
+	if (utc_time_is_calibrated()) {
+		demo_arm();
+	}
+	LOG_INF("UTC trigger demo: test timer start on every UTC second (%s)",
+		demo.armed ? "armed" : "waiting for calibration");
+
+	return 0;
+}
+
+void utc_trigger_demo_print(void)
+{
+	LOG_INF("UTC trigger: %u starts, start error p50 %u, p99 %u, max %u us",
+		demo_starts,
+		latency_hist_percentile(&start_error_hist, 500),
+		latency_hist_percentile(&start_error_hist, 990),
+		latency_hist_max(&start_error_hist));
+}
+
+#endif /* CONFIG_APP_UTC_TRIGGER_DEMO */
@@ -0,0 +1,97 @@
+/*
+ * UTC-triggered peripheral tasks - Header File
+ *
+ * Starts a peripheral task (ADC sample, TIMER start, radio ramp-up,
+ * ...) at an exact UTC instant: the deadline is converted to a GRTC
+ * compare value whose event is published on a (D)PPI channel to the
+ * task (grtc_trigger.h).  No CPU is involved at the instant, so there
+ * is no interrupt latency or jitter.  Armed triggers are converted
+ * again whenever the clock is recalibrated; a deadline that the new
+ * calibration puts in the past fires at once, and all deadlines are
+ * dropped if the clock loses its calibration.
+ *
+ * CONFIG_APP_UTC_TRIGGER_DEMO starts the test timer on every UTC second
+ * and measures the start error against the GRTC.
+ */
+
+#ifndef UTC_TRIGGER_H
+#define UTC_TRIGGER_H
+
+#include <stdint.h>
+
+#ifdef CONFIG_APP_UTC_TRIGGER
+
+#include <zephyr/sys/slist.h>
+#include "grtc_trigger.h"
+
+struct utc_trigger;
+
+/**
+ * @brief Called from the GRTC interrupt after the task was triggered
+ *
+ * @param trigger The trigger that fired
+ * @param grtc_us GRTC value the task was triggered at
+ */
+typedef void (*utc_trigger_handler_t)(struct utc_trigger *trigger, uint64_t grtc_us);
+
+struct utc_trigger {
+	struct grtc_trigger grtc;
+	sys_snode_t node;
+	uint64_t utc_us;
+	utc_trigger_handler_t handler;
+	bool armed;
+};
+
+/**
+ * @brief Connect a trigger to a peripheral task
+ *
+ * @param trigger Trigger to set up
+ * @param task_addr Address of the task register, e.g. from
+ * nrf_timer_task_address_get()
+ * @return 0 on success, -ENOMEM if no GRTC or PPI channel is free
+ */
+int utc_trigger_init(struct utc_trigger *trigger, uint32_t task_addr);
+
+/**
+ * @brief Trigger the task at a UTC instant
+ *
+ * Replaces a pending deadline of the same trigger.
+ *
+ * @param trigger Trigger from utc_trigger_init()
+ * @param utc_us UTC deadline in microseconds
+ * @param handler Called after the task was triggered, or NULL
+ * @return 0 on success, -EAGAIN if the clock is not calibrated,
+ * -ETIME if the deadline has already passed
+ */
+int utc_trigger_arm(struct utc_trigger *trigger, uint64_t utc_us,
+		    utc_trigger_handler_t handler);
+
+/**
+ * @brief Cancel a pending deadline
+ */
+void utc_trigger_cancel(struct utc_trigger *trigger);
+
+#endif /* CONFIG_APP_UTC_TRIGGER */
+
+#ifdef CONFIG_APP_UTC_TRIGGER_DEMO
+
+/**
+ * @brief Start the test timer on every UTC second once calibrated
+ *
+ * @return 0 on success, negative errno if no channel is free
+ */
+int utc_trigger_demo_init(void);
+
+/**
+ * @brief Log the start count and the measured start error
+ */
+void utc_trigger_demo_print(void);
+
+#else
+
+static inline int utc_trigger_demo_init(void) { return 0; }
+static inline void utc_trigger_demo_print(void) {}
+
+#endif /* CONFIG_APP_UTC_TRIGGER_DEMO */
+
+#endif /* UTC_TRIGGER_H */
@@ -0,0 +1,349 @@
+/*
+ * Warm-start cache
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+#include "warm_cache.h"
+#include "grtc.h"
+#include "retained.h"
+#include "warm_cache_image_id.h"
+
+#if defined(CONFIG_BOOTLOADER_MCUBOOT) && defined(CONFIG_FLASH_MAP)
+#include <zephyr/storage/flash_map.h>
+#define WARM_CACHE_MCUBOOT_ID
+#endif
+
+LOG_MODULE_REGISTER(warm_cache, LOG_LEVEL_INF);
+
+/* Slot sizes in bytes, the largest entry each user stores */
+static const uint16_t slot_sizes[] = {
+	[WARM_CACHE_DEMO] = 512,
+#ifdef CONFIG_APP_WARM_CACHE_DEMO
+	[WARM_CACHE_CHECK] = 16,
+#endif
+};
+
+BUILD_ASSERT(ARRAY_SIZE(slot_sizes) == WARM_CACHE_SLOTS, "warm cache slot without a size");
+
+/* At the start of the window; counters since the image was installed */
+struct cache_header {
+	uint32_t image;
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t reserved;
+	uint64_t saved_us;
+};
+
+/* Each slot: this header and its CRC, then the entry and its CRC */
+struct slot_header {
+	uint32_t image;
+	uint32_t key;
+	uint32_t len;
+	uint32_t cost_us;
+};
+
+#define HEADER_STRIDE ROUND_UP(sizeof(struct cache_header) + sizeof(uint32_t), 8)
+#define SLOT_DATA_OFFSET (sizeof(struct slot_header) + sizeof(uint32_t))
+#define SLOT_STRIDE(size) ROUND_UP(SLOT_DATA_OFFSET + (size) + sizeof(uint32_t), 4)
+
+static uint16_t slot_offsets[WARM_CACHE_SLOTS];
+static struct cache_header header;
+static uint32_t image;
+
+/* This boot */
+static uint32_t boot_hits;
+static uint32_t boot_misses;
+static uint64_t boot_saved_us;
+
+#ifdef WARM_CACHE_MCUBOOT_ID
+/* MCUboot image format: header, image, protected TLVs, TLVs */
+#define IMAGE_MAGIC          0x96f3b83dU
+#define IMAGE_TLV_INFO_MAGIC 0x6907U
+#define IMAGE_TLV_SHA256     0x10U
+#define IMAGE_TLV_SHA512     0x12U
+
+struct image_header {
+	uint32_t magic;
+	uint32_t load_addr;
+	uint16_t hdr_size;
+	uint16_t protect_tlv_size;
+	uint32_t img_size;
+	uint32_t flags;
+	uint8_t version[8];
+	uint32_t pad;
+};
+
+struct image_tlv {
+	uint16_t type;           /* magic and total size for the info */
+	uint16_t len;
+};
+
+/* CRC-32 of the SHA TLV of the running image */
+static int image_hash_crc(uint32_t *crc)
+{
+	const struct flash_area *fa;
+	struct image_header hdr;
+	struct image_tlv tlv;
+	uint8_t hash[64];
+	off_t off;
+	off_t end;
+	int err = flash_area_open(FIXED_PARTITION_ID(slot0_partition), &fa);
+
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_read(fa, 0, &hdr, sizeof(hdr));
+	if (err == 0 && hdr.magic != IMAGE_MAGIC) {
+		err = -ENOENT;
+	}
+	if (err == 0) {
+		off = hdr.hdr_size + hdr.img_size + hdr.protect_tlv_size;
+		err = flash_area_read(fa, off, &tlv, sizeof(tlv));
+	}
+	if (err == 0 && tlv.type != IMAGE_TLV_INFO_MAGIC) {
+		err = -ENOENT;
+	}
+	if (err) {
+		flash_area_close(fa);
+		return err;
+	}
+
+	/* Pure signatures (e.g. ED25519 over the image) have no hash */
+	err = -ENOENT;
+	end = off + tlv.len;
+	for (off += sizeof(tlv); off + (off_t)sizeof(tlv) <= end; off += tlv.len) {
+		if (flash_area_read(fa, off, &tlv, sizeof(tlv)) != 0) {
+			break;
+		}
+		off += sizeof(tlv);
+		if (tlv.type >= IMAGE_TLV_SHA256 && tlv.type <= IMAGE_TLV_SHA512 &&
+		    tlv.len <= sizeof(hash)) {
+			err = flash_area_read(fa, off, hash, tlv.len);
+			if (err == 0) {
+				*crc = crc32_ieee(hash, tlv.len);
+			}
+			break;
+		}
+	}
+
+	flash_area_close(fa);
+	return err;
+}
+#endif /* WARM_CACHE_MCUBOOT_ID */
+
+static uint32_t image_id(void)
+{
+#ifdef WARM_CACHE_MCUBOOT_ID
+	uint32_t crc;
+
+	if (image_hash_crc(&crc) == 0) {
+		return crc;
+	}
+	LOG_WRN("Warm cache: no image hash, using the build id");
+#endif
+	/* Hash of the sources, .config and devicetree (CMakeLists.txt) */
+	return WARM_CACHE_IMAGE_ID;
+}
+
+static void header_store(void)
+{
+	(void)retained_blob_write(RETAINED_WARM_CACHE_OFFSET, &header, sizeof(header));
+}
+
+void warm_cache_init(void)
+{
+	size_t offset = HEADER_STRIDE;
+
+	for (size_t i = 0; i < WARM_CACHE_SLOTS; i++) {
+		slot_offsets[i] = RETAINED_WARM_CACHE_OFFSET + offset;
+		offset += SLOT_STRIDE(slot_sizes[i]);
+	}
+	__ASSERT(offset <= RETAINED_WARM_CACHE_SIZE, "warm cache slots exceed the window");
+
+	image = image_id();
+
+	/* Entries of another image no longer match: they carry its id */
+	if (retained_blob_read(RETAINED_WARM_CACHE_OFFSET, &header, sizeof(header)) != 0 ||
+	    header.image != image) {
+		memset(&header, 0, sizeof(header));
+		header.image = image;
+		header_store();
+		LOG_INF("Warm cache: image %08x, starting empty", image);
+	}
+}
+
+static int lookup(enum warm_cache_slot slot, uint32_t key, void *data, size_t len,
+		  uint32_t *cost_us)
+{
+	struct slot_header sh;
+	int err = retained_blob_read(slot_offsets[slot], &sh, sizeof(sh));
+
+	if (err) {
+		return err;
+	}
+	if (sh.image != image || sh.key != key || sh.len != len) {
+		return -ENOENT;
+	}
+
+	*cost_us = sh.cost_us;
+	return retained_blob_read(slot_offsets[slot] + SLOT_DATA_OFFSET, data, len);
+}
+
+int warm_cache_get(enum warm_cache_slot slot, uint32_t key, void *data, size_t len)
+{
+	uint32_t cost_us = 0;
+	int err;
+
+	__ASSERT_NO_MSG(slot < WARM_CACHE_SLOTS);
+
+	err = lookup(slot, key, data, len, &cost_us);
+	if (err == 0) {
+		boot_hits++;
+		boot_saved_us += cost_us;
+		header.hits++;
+		header.saved_us += cost_us;
+	} else {
+		boot_misses++;
+		header.misses++;
+	}
+	header_store();
+
+	return err;
+}
+
+int warm_cache_put(enum warm_cache_slot slot, uint32_t key, const void *data, size_t len,
+		   uint32_t cost_us)
+{
+	struct slot_header sh = {
+		.image = ~image,
+		.key = key,
+		.len = len,
+		.cost_us = cost_us,
+	};
+
+	__ASSERT_NO_MSG(slot < WARM_CACHE_SLOTS);
+
+	if (len > slot_sizes[slot]) {
+		return -EINVAL;
+	}
+
+	/* Empty the slot first: a reset before the last write must not
+	 * leave the old header in front of new data of the same size.
+	 */
+	(void)retained_blob_write(slot_offsets[slot], &sh, sizeof(sh));
+	(void)retained_blob_write(slot_offsets[slot] + SLOT_DATA_OFFSET, data, len);
+	sh.image = image;
+
+	return retained_blob_write(slot_offsets[slot], &sh, sizeof(sh));
+}
+
+void warm_cache_print(void)
+{
+	LOG_INF("Warm cache: this boot %u hits, %u misses, %llu us saved", boot_hits,
+		boot_misses, boot_saved_us);
+	LOG_INF("Warm cache: image %08x %u hits, %u misses, %llu ms saved", image,
+		header.hits, header.misses, header.saved_us / 1000U);
+}
+
+#ifdef CONFIG_APP_WARM_CACHE_DEMO
+/* Frequency correction of a tuning-fork crystal in ppb per degree
+ * from -40 to 85 C.  The busy wait stands in for the time a real
+ * table - fitted to factory calibration data, say - takes to build.
+ */
+#define DEMO_T_MIN_C     (-40)
+#define DEMO_ENTRIES     126
+#define DEMO_TURNOVER_C  25
+#define DEMO_PARABOLA    34      /* ppb / C^2 */
+
+static int32_t demo_table[DEMO_ENTRIES];
+
+BUILD_ASSERT(sizeof(demo_table) <= 512, "demo table exceeds its warm cache slot");
+
+#define CHECK_KEY     0x5eed0001U
+#define CHECK_COST_US 1234U
+
+/* Put, hit, and the misses of another key and of another image; the
+ * counters are put back afterwards.  Returns the number of failures.
+ */
+static uint32_t check(void)
+{
+	const uint32_t entry[4] = { 1, 2, 3, 4 };
+	uint32_t out[4] = { 0 };
+	uint32_t own_image = image;
+	uint32_t hits = boot_hits;
+	uint32_t misses = boot_misses;
+	uint64_t saved_us = boot_saved_us;
+	struct cache_header saved_header = header;
+	uint32_t failed = 0;
+
+	failed += (warm_cache_put(WARM_CACHE_CHECK, CHECK_KEY, entry, sizeof(entry),
+				  CHECK_COST_US) == 0) ? 0U : 1U;
+	failed += (warm_cache_get(WARM_CACHE_CHECK, CHECK_KEY, out, sizeof(out)) == 0 &&
+		   memcmp(out, entry, sizeof(entry)) == 0) ? 0U : 1U;
+	failed += (warm_cache_get(WARM_CACHE_CHECK, CHECK_KEY + 1U, out, sizeof(out)) ==
+		   -ENOENT) ? 0U : 1U;
+	failed += (warm_cache_put(WARM_CACHE_CHECK, CHECK_KEY, entry,
+				  slot_sizes[WARM_CACHE_CHECK] + 1U, 0) == -EINVAL) ? 0U : 1U;
+
+	/* Stored by the previous image, looked up after an update */
+	image = ~own_image;
+	(void)warm_cache_put(WARM_CACHE_CHECK, CHECK_KEY, entry, sizeof(entry), CHECK_COST_US);
+	image = own_image;
+	failed += (warm_cache_get(WARM_CACHE_CHECK, CHECK_KEY, out, sizeof(out)) ==
+		   -ENOENT) ? 0U : 1U;
+
+	failed += (boot_hits == hits + 1U && boot_misses == misses + 2U &&
+		   boot_saved_us == saved_us + CHECK_COST_US) ? 0U : 1U;
+	failed += (header.hits == saved_header.hits + 1U &&
+		   header.misses == saved_header.misses + 2U &&
+		   header.saved_us == saved_header.saved_us + CHECK_COST_US) ? 0U : 1U;
+
+	boot_hits = hits;
+	boot_misses = misses;
+	boot_saved_us = saved_us;
+	header = saved_header;
+	header_store();
+
+	return failed;
+}
+
+void warm_cache_demo_run(void)
+{
+	/* What the table is derived from */
+	const int32_t params[] = {
+		DEMO_T_MIN_C, DEMO_ENTRIES, DEMO_TURNOVER_C, DEMO_PARABOLA,
+	};
+	uint32_t key = crc32_ieee((const uint8_t *)params, sizeof(params));
+	uint64_t start;
+	uint32_t cost_us;
+	uint32_t failed = check();
+
+	if (failed != 0U) {
+		LOG_ERR("Warm cache check: FAIL (%u)", failed);
+	} else {
+		LOG_INF("Warm cache check: PASS");
+	}
+
+	if (warm_cache_get(WARM_CACHE_DEMO, key, demo_table, sizeof(demo_table)) == 0) {
+		LOG_INF("Warm cache demo: table restored, %d ppb at %d C", demo_table[0],
+			DEMO_T_MIN_C);
+		return;
+	}
+
+	start = grtc_read_us();
+	for (int i = 0; i < DEMO_ENTRIES; i++) {
+		int32_t d = DEMO_T_MIN_C + i - DEMO_TURNOVER_C;
+
+		demo_table[i] = DEMO_PARABOLA * d * d;
+	}
+	k_busy_wait(CONFIG_APP_WARM_CACHE_DEMO_COST_MS * USEC_PER_MSEC);
+	cost_us = (uint32_t)(grtc_read_us() - start);
+
+	(void)warm_cache_put(WARM_CACHE_DEMO, key, demo_table, sizeof(demo_table), cost_us);
+	LOG_INF("Warm cache demo: table built in %u us", cost_us);
+}
+#endif /* CONFIG_APP_WARM_CACHE_DEMO */
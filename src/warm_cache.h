@@ -0,0 +1,102 @@
+/*
+ * Warm-start cache - Header File
+ *
+ * Derived state that is expensive to build at boot (calibration and
+ * lookup tables, parsed configuration) is kept in the retained region
+ * (window RETAINED_WARM_CACHE_OFFSET) and handed back after a reset
+ * instead of being rebuilt.  Each user owns a fixed slot, so a lookup
+ * is one CRC-checked read at a known offset.
+ *
+ * An entry is returned only if it was stored by the same image and
+ * under the same content key.  The image is identified by the hash
+ * MCUboot checked (the SHA TLV of the primary slot); without MCUboot
+ * by a hash of the application sources, .config, devicetree and Zephyr
+ * version generated at build time (scripts/image_id.cmake).  The
+ * content key is up to the user: a hash of whatever the
+ * entry is derived from, so that e.g. a changed setting misses.
+ *
+ * Users pass the time the entry took to build when storing it; every
+ * hit adds it to the time saved.  Hits, misses and time saved are
+ * counted for this boot and, in the retained window, since the image
+ * was installed.
+ */
+
+#ifndef WARM_CACHE_H
+#define WARM_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* One slot per user; sizes in warm_cache.c */
+enum warm_cache_slot {
+	WARM_CACHE_DEMO,            /* compensation table, CONFIG_APP_WARM_CACHE_DEMO */
+#ifdef CONFIG_APP_WARM_CACHE_DEMO
+	WARM_CACHE_CHECK,           /* self check of the demo */
+#endif
+	WARM_CACHE_SLOTS,
+};
+
+#ifdef CONFIG_APP_WARM_CACHE
+
+/**
+ * @brief Identify the image and drop the counters of another image
+ *
+ * Call once at boot before the first lookup.
+ */
+void warm_cache_init(void);
+
+/**
+ * @brief Look up an entry
+ *
+ * @param slot Slot of the caller
+ * @param key Content key the entry was stored under
+ * @param data Filled with the entry; undefined on a miss
+ * @param len Size of the entry
+ * @return 0 on a hit, -ENOENT if the slot is empty or holds another
+ * key, size or image, -EBADMSG if it failed its CRC
+ */
+int warm_cache_get(enum warm_cache_slot slot, uint32_t key, void *data, size_t len);
+
+/**
+ * @brief Store an entry, replacing the slot's previous one
+ *
+ * A reset in the middle leaves the slot empty, never half written.
+ *
+ * @param slot Slot of the caller
+ * @param key Content key
+ * @param data Entry
+ * @param len Size of the entry, at most the slot size
+ * @param cost_us Time it took to build the entry
+ * @return 0 on success, -EINVAL if @p len exceeds the slot
+ */
+int warm_cache_put(enum warm_cache_slot slot, uint32_t key, const void *data, size_t len,
+		   uint32_t cost_us);
+
+/**
+ * @brief Log hits, misses and time saved, this boot and since the
+ * image was installed
+ */
+void warm_cache_print(void);
+
+#else
+
+static inline void warm_cache_init(void) {}
+static inline void warm_cache_print(void) {}
+
+#endif /* CONFIG_APP_WARM_CACHE */
+
+#ifdef CONFIG_APP_WARM_CACHE_DEMO
+
+/**
+ * @brief Check hits and misses on a scratch slot, then get the demo
+ * table from the cache or build it
+ */
+void warm_cache_demo_run(void);
+
+#else
+
+static inline void warm_cache_demo_run(void) {}
+
+#endif /* CONFIG_APP_WARM_CACHE_DEMO */
+
+#endif /* WARM_CACHE_H */
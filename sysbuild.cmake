@@ -0,0 +1,13 @@
+# SPDX-License-Identifier: Apache-2.0
+
+if(SB_CONFIG_APP_COPROC)
+  ExternalZephyrProject_Add(
+    APPLICATION coproc
+    SOURCE_DIR ${APP_DIR}/coproc
+    BOARD ${SB_CONFIG_APP_COPROC_BOARD}
+  )
+  set_config_bool(${DEFAULT_IMAGE} CONFIG_APP_COPROC y)
+  # The shared memory node exists only in builds with the coprocessor
+  sysbuild_cache_set(VAR ${DEFAULT_IMAGE}_EXTRA_DTC_OVERLAY_FILE APPEND REMOVE_DUPLICATES
+                     ${APP_DIR}/boards/nrf54l15dk_nrf54l15_cpuapp_coproc.overlay)
+endif()